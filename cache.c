@@ -0,0 +1,262 @@
+/*
+ * @file cache.c
+ * @brief data cache maintenance for DMA buffers
+ *
+ * The CPU marks what it writes with cacheDirty() and the ranges are flushed
+ * together by cacheCommit() when a transmit starts.  Buffers a device writes
+ * are invalidated over the bytes it wrote once it is done.  DMA buffers
+ * should start and end on a cache line, the pools give FRAME_ALIGN buffers.
+ */
+
+#include "cache.h"
+#include "xil_cache.h"
+
+static cache_struct cache;
+
+#define LINE_DOWN(a)	((u32)(a) & ~(CACHE_LINE_SIZE - 1))
+#define LINE_UP(a)		(((u32)(a) + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1))
+
+HOT_CODE static void cacheFlushLines(u32 start, unsigned int length) {
+
+	Xil_DCacheFlushRange(start, length);
+
+	cache.flushes++;
+	cache.flushBytes += length;
+}
+
+HOT_CODE static void cacheInvalidateLines(u32 start, unsigned int length) {
+
+	Xil_DCacheInvalidateRange(start, length);
+
+	cache.invalidates++;
+	cache.invalidateBytes += length;
+}
+
+/*****************************************************************************/
+/**
+ * @brief settle the pending ranges a device is about to write over
+ * This function throws away pending dirty lines wholly inside the range, as
+ * the device data replaces them, and flushes pending ranges and partial
+ * lines at the ends that hold CPU data outside the range
+ *
+ * @param	addr holds the start of the range
+ * @param	length holds the bytes in the range
+ * @param	discard holds 1 to invalidate the thrown away lines here, 0 if the
+ * 			caller invalidates the whole range anyway
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE static void cacheSettle(u32 addr, unsigned int length, int discard) {
+
+	u32 start = LINE_DOWN(addr);
+	u32 end = LINE_UP(addr + length);
+	u32 wholeStart = LINE_UP(addr);
+	u32 wholeEnd = LINE_DOWN(addr + length);
+	cache_range_struct *r;
+	unsigned int i = 0;
+
+	while(i < cache.pendingCount) {
+		r = &cache.pending[i];
+
+		if((r->end <= start) || (r->start >= end)) {
+			i++;
+			continue;
+		}
+
+		if((r->start >= wholeStart) && (r->end <= wholeEnd)) {
+			if(discard)
+				cacheInvalidateLines(r->start, r->end - r->start);
+			cache.dropped++;
+		} else
+			cacheFlushLines(r->start, r->end - r->start);
+
+		*r = cache.pending[--cache.pendingCount];
+	}
+
+	if(start != wholeStart)
+		cacheFlushLines(start, CACHE_LINE_SIZE);
+
+	if((end != wholeEnd) && !((start != wholeStart) && (end - CACHE_LINE_SIZE == start)))
+		cacheFlushLines(end - CACHE_LINE_SIZE, CACHE_LINE_SIZE);
+}
+
+/*****************************************************************************/
+/**
+ * @brief note a range the CPU has written and a device will read
+ * This function widens the range to whole lines and merges it with any
+ * pending range it touches, so frames laid out back to back are flushed in
+ * one pass.
+ *
+ * @param	addr is a pointer to the first byte written
+ * @param	length holds the bytes written
+ *
+ * @return	none
+ *
+ * @note 	the range reaches DDR at the next cacheCommit()
+ *
+******************************************************************************/
+HOT_CODE void cacheDirty(const void *addr, unsigned int length) {
+
+	u32 start, end;
+	cache_range_struct *r;
+	unsigned int i, j;
+
+	if(length == 0)
+		return;
+
+	start = LINE_DOWN(addr);
+	end = LINE_UP((u32)addr + length);
+
+	for(i = 0; i < cache.pendingCount; i++) {
+		r = &cache.pending[i];
+
+		if((start > r->end) || (end < r->start))
+			continue;
+
+		if(start < r->start)
+			r->start = start;
+		if(end > r->end)
+			r->end = end;
+
+		cache.merged++;
+
+		/*
+		 * the wider range may now reach others
+		 */
+		j = 0;
+		while(j < cache.pendingCount) {
+			if((j != i) && (cache.pending[j].start <= r->end) && (cache.pending[j].end >= r->start)) {
+				if(cache.pending[j].start < r->start)
+					r->start = cache.pending[j].start;
+				if(cache.pending[j].end > r->end)
+					r->end = cache.pending[j].end;
+
+				cache.pending[j] = cache.pending[--cache.pendingCount];
+				if(i == cache.pendingCount) {			// r was the last entry and has moved
+					i = j;
+					r = &cache.pending[i];
+				}
+			} else
+				j++;
+		}
+
+		return;
+	}
+
+	if(cache.pendingCount == CACHE_PENDING) {
+		cache.full++;
+		cacheCommit();
+	}
+
+	cache.pending[cache.pendingCount].start = start;
+	cache.pending[cache.pendingCount].end = end;
+	cache.pendingCount++;
+}
+
+/*****************************************************************************/
+/**
+ * @brief flush every pending dirty range
+ *
+ * @return	none
+ *
+ * @note 	called before a transmit starts
+ *
+******************************************************************************/
+HOT_CODE void cacheCommit(void) {
+
+	unsigned int i;
+
+	for(i = 0; i < cache.pendingCount; i++)
+		cacheFlushLines(cache.pending[i].start, cache.pending[i].end - cache.pending[i].start);
+
+	cache.pendingCount = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief flush a range now
+ * This function is for data a device reads straight away that the CPU
+ * wrote without marking it, such as a test pattern or a preloaded frame
+ *
+ * @param	addr is a pointer to the first byte
+ * @param	length holds the bytes to flush
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE void cacheFlush(const void *addr, unsigned int length) {
+
+	if(length == 0)
+		return;
+
+	cacheFlushLines(LINE_DOWN(addr), LINE_UP((u32)addr + length) - LINE_DOWN(addr));
+}
+
+/*****************************************************************************/
+/**
+ * @brief get a buffer ready for a device to write
+ * This function makes sure no dirty line the CPU marked can later be
+ * written back over the device data.  Nothing is done over ranges the CPU
+ * has not marked.
+ *
+ * @param	addr is a pointer to the buffer
+ * @param	length holds the bytes the device may write
+ *
+ * @return	none
+ *
+ * @note 	a buffer the CPU wrote without cacheDirty() needs
+ * 			cacheInvalidate() instead
+ *
+******************************************************************************/
+HOT_CODE void cacheReceive(const void *addr, unsigned int length) {
+
+	if(length == 0)
+		return;
+
+	cacheSettle((u32)addr, length, 1);
+}
+
+/*****************************************************************************/
+/**
+ * @brief drop cached copies of a range a device has written
+ *
+ * @param	addr is a pointer to the first byte
+ * @param	length holds the bytes to invalidate
+ *
+ * @return	none
+ *
+ * @note 	partial lines at the ends are flushed first so CPU data next to
+ * 			the range is kept
+ *
+******************************************************************************/
+HOT_CODE void cacheInvalidate(const void *addr, unsigned int length) {
+
+	if(length == 0)
+		return;
+
+	cacheSettle((u32)addr, length, 0);
+
+	cacheInvalidateLines(LINE_DOWN(addr), LINE_UP((u32)addr + length) - LINE_DOWN(addr));
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the cache maintenance counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayCache(void) {
+
+	xil_printf("\nCache flushes \t\t- %d (%d bytes)\n", cache.flushes, cache.flushBytes);
+	xil_printf("Cache invalidates \t- %d (%d bytes)\n", cache.invalidates, cache.invalidateBytes);
+	xil_printf("Dirty ranges \t\t- %d pending, %d merged, %d dropped, %d full\n",
+			cache.pendingCount, cache.merged, cache.dropped, cache.full);
+}
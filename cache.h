@@ -0,0 +1,50 @@
+/*
+ * @file cache.h
+ */
+
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include "common.h"
+
+#ifdef XPAR_MICROBLAZE_DCACHE_LINE_LEN
+#define CACHE_LINE_SIZE		(XPAR_MICROBLAZE_DCACHE_LINE_LEN * 4)
+#else
+#define CACHE_LINE_SIZE		32
+#endif
+
+#define CACHE_PENDING		8			// dirty ranges waiting for a flush
+
+/**
+ * @struct cache_range_struct
+ * @brief range of whole cache lines
+ */
+typedef struct cache_range_type {
+	u32				start;
+	u32				end;				//!< first byte past the range
+} cache_range_struct;
+
+/**
+ * @struct cache_struct
+ * @brief dirty ranges waiting for a flush and the maintenance counters
+ */
+typedef struct cache_type {
+	cache_range_struct	pending[CACHE_PENDING];
+	unsigned int		pendingCount;
+	unsigned int		flushes;		//!< flush operations
+	unsigned int		flushBytes;		//!< bytes flushed
+	unsigned int		invalidates;	//!< invalidate operations
+	unsigned int		invalidateBytes;//!< bytes invalidated
+	unsigned int		merged;			//!< dirty ranges merged into a pending one
+	unsigned int		dropped;		//!< pending ranges a receive made moot
+	unsigned int		full;			//!< early commits with the pending list full
+} cache_struct;
+
+void cacheDirty(const void *, unsigned int);
+void cacheCommit(void);
+void cacheFlush(const void *, unsigned int);
+void cacheReceive(const void *, unsigned int);
+void cacheInvalidate(const void *, unsigned int);
+void displayCache(void);
+
+#endif /* CACHE_H_ */
@@ -0,0 +1,431 @@
+/*
+ * @file capture.c
+ * @brief DDR flight-recorder capture ring
+ */
+
+#include <string.h>
+
+#include "capture.h"
+#include "timer.h"
+#include "dma.h"
+
+static capture_struct capture;
+static capture_trigger_struct trigger;
+
+/*****************************************************************************/
+/**
+ * @brief initialize the capture ring
+ * This function empties the capture ring.  Frame data goes to CAPTURE_BASE -
+ * CAPTURE_HIGH and the index to CAPTURE_INDEX_BASE.
+ *
+ * @return	none
+ *
+ * @note 	recording is left disabled
+ *
+******************************************************************************/
+void captureInit(void) {
+
+	capture.data = (u8 *)CAPTURE_BASE;
+	capture.dataSize = CAPTURE_HIGH - CAPTURE_BASE + 1;
+	capture.writeOffset = 0;
+	capture.index = (capture_index_struct *)CAPTURE_INDEX_BASE;
+	capture.indexSize = CAPTURE_INDEX_ENTRIES;
+	capture.head = 0;
+	capture.tail = 0;
+	capture.count = 0;
+	capture.sequence = 0;
+	capture.enabled = 0;
+	capture.evicted = 0;
+
+	trigger.state = TRIGGER_IDLE;
+}
+
+/*****************************************************************************/
+/**
+ * @brief enable or disable recording
+ *
+ * @param	enable 1-record, 0-stop
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+void captureEnable(int enable) {
+
+	capture.enabled = enable;
+}
+
+/*****************************************************************************/
+/**
+ * @brief check if recording is enabled
+ *
+ * @return	1-enabled, 0-disabled
+ *
+ * @note 	none
+ *
+******************************************************************************/
+int captureEnabled(void) {
+
+	return capture.enabled;
+}
+
+/*****************************************************************************/
+/**
+ * @brief drop the oldest index entry
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE static void captureEvict(void) {
+
+	capture.tail++;
+	if(capture.tail == capture.indexSize)
+		capture.tail = 0;
+
+	capture.count--;
+	capture.evicted++;
+}
+
+/*****************************************************************************/
+/**
+ * @brief fire the trigger
+ * This function starts the post-trigger window, the ring freezes once the
+ * window has been recorded
+ *
+ * @param	cause holds the trigger source
+ * @param	sequence holds the capture sequence number at the trigger
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+static void triggerFire(unsigned int cause, unsigned int sequence) {
+
+	trigger.state = TRIGGER_FIRED;
+	trigger.cause = cause;
+	trigger.sequence = sequence;
+	trigger.remaining = trigger.postFrames;
+
+	if(trigger.remaining == 0) {
+		capture.enabled = 0;
+		trigger.state = TRIGGER_FROZEN;
+	}
+}
+
+/*****************************************************************************/
+/**
+ * @brief check a recorded frame against the trigger
+ *
+ * @param	frame is a pointer to the start of the frame
+ * @param	size holds the frame size in bytes
+ * @param	sequence holds the capture sequence number of the frame
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE static void triggerCheckFrame(u8 *frame, unsigned int size, unsigned int sequence) {
+
+	unsigned int *words = (unsigned int *)frame;
+	unsigned int value;
+
+	if((trigger.sources & TRIGGER_SEQUENCE_GAP) && (trigger.sequenceWord < (size / 4))) {
+		value = words[trigger.sequenceWord];
+
+		if(trigger.sequenceValid && (value != (trigger.lastSequence + 1))) {
+			triggerFire(TRIGGER_SEQUENCE_GAP, sequence);
+			return;
+		}
+
+		trigger.lastSequence = value;
+		trigger.sequenceValid = 1;
+	}
+
+	if((trigger.sources & TRIGGER_HEADER_MATCH) && (trigger.matchWord < (size / 4))) {
+		if((words[trigger.matchWord] & trigger.matchMask) == trigger.matchValue)
+			triggerFire(TRIGGER_HEADER_MATCH, sequence);
+	}
+}
+
+/*****************************************************************************/
+/**
+ * @brief record a frame
+ * This function copies a frame into the data ring and adds an index entry.
+ * Frames are never split across the end of the ring, a frame that does not
+ * fit wraps to the start.  Only the oldest entries can be overwritten, so
+ * making room is a check of the tail entry rather than a search.
+ *
+ * @param	frame is a pointer to the start of the frame
+ * @param	size holds the frame size in bytes
+ *
+ * @return	none
+ *
+ * @note 	does nothing while recording is disabled
+ *
+******************************************************************************/
+HOT_CODE void captureFrame(u8 *frame, unsigned int size) {
+
+	capture_index_struct *entry;
+	unsigned int end;
+
+	if(!capture.enabled || (size > capture.dataSize))
+		return;
+
+	/*
+	 * wrap, everything past the write offset is older than what is at the start
+	 */
+	if(size > (capture.dataSize - capture.writeOffset)) {
+		while(capture.count && (capture.index[capture.tail].offset >= capture.writeOffset))
+			captureEvict();
+
+		capture.writeOffset = 0;
+	}
+
+	end = capture.writeOffset + size;
+
+	while(capture.count && (capture.index[capture.tail].offset >= capture.writeOffset) &&
+			(capture.index[capture.tail].offset < end))
+		captureEvict();
+
+	if(capture.count == capture.indexSize)
+		captureEvict();
+
+	memcpy(capture.data + capture.writeOffset, frame, size);
+
+	entry = &capture.index[capture.head];
+	entry->offset = capture.writeOffset;
+	entry->length = size;
+	entry->timestamp = timerGetTicks();
+	entry->sequence = capture.sequence++;
+
+	capture.head++;
+	if(capture.head == capture.indexSize)
+		capture.head = 0;
+
+	capture.count++;
+
+	capture.writeOffset = (end + 3) & ~3;			// keep frames word aligned
+
+	if(trigger.state == TRIGGER_FIRED) {
+		trigger.remaining--;
+		if(trigger.remaining == 0) {
+			capture.enabled = 0;
+			trigger.state = TRIGGER_FROZEN;
+		}
+	} else if(trigger.state == TRIGGER_ARMED) {
+		triggerCheckFrame(frame, size, entry->sequence);
+	}
+}
+
+/*****************************************************************************/
+/**
+ * @brief get a capture index entry
+ *
+ * @param	age holds how many frames back to go, 0 is the newest frame
+ *
+ * @return	pointer to the index entry, NULL if the frame is not in the ring
+ *
+ * @note 	none
+ *
+******************************************************************************/
+capture_index_struct *captureGetEntry(unsigned int age) {
+
+	unsigned int i;
+
+	if(age >= capture.count)
+		return NULL;
+
+	if(capture.head > age)
+		i = capture.head - 1 - age;
+	else
+		i = capture.indexSize + capture.head - 1 - age;
+
+	return &capture.index[i];
+}
+
+/*****************************************************************************/
+/**
+ * @brief number of frames in the capture ring
+ *
+ * @return	number of valid index entries
+ *
+ * @note 	none
+ *
+******************************************************************************/
+unsigned int captureCount(void) {
+
+	return capture.count;
+}
+
+/*****************************************************************************/
+/**
+ * @brief get the data for a capture index entry
+ *
+ * @param	entry is a pointer to the index entry
+ *
+ * @return	pointer to the start of the captured frame
+ *
+ * @note 	none
+ *
+******************************************************************************/
+u8 *captureGetFrame(capture_index_struct *entry) {
+
+	return capture.data + entry->offset;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the capture ring
+ * This function displays the capture state and the newest index entries
+ *
+ * @param	entries holds the number of index entries to display
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayCapture(unsigned int entries) {
+
+	unsigned int i;
+	capture_index_struct *entry;
+
+	xil_printf("\nCapture %s\n", capture.enabled ? "enabled" : "disabled");
+	xil_printf("Frames in ring \t\t- %d\n", capture.count);
+	xil_printf("Frames recorded \t- %d\n", capture.sequence);
+	xil_printf("Frames overwritten \t- %d\n", capture.evicted);
+
+	switch (trigger.state) {
+		case TRIGGER_ARMED :
+			xil_printf("Trigger \t\t- armed (0x%02X)\n", trigger.sources);
+			break;
+		case TRIGGER_FIRED :
+		case TRIGGER_FROZEN :
+			xil_printf("Trigger \t\t- %s by 0x%02X at sequence %d\n",
+					(trigger.state == TRIGGER_FIRED) ? "fired" : "frozen", trigger.cause, trigger.sequence);
+			xil_printf("Window \t\t\t- %d before, %d after", trigger.preFrames, trigger.postFrames);
+			entry = captureGetEntry(capture.count - 1);
+			if((entry != NULL) && ((trigger.sequence - entry->sequence) < trigger.preFrames))
+				xil_printf(" (only %d before retained)", trigger.sequence - entry->sequence);
+			xil_printf("\n");
+			break;
+		default :
+			break;
+	}
+
+	if(entries)
+		xil_printf("\nsequence   address    length     timestamp\n");
+
+	for(i = 0; i < entries; i++) {
+		entry = captureGetEntry(i);
+		if(entry == NULL)
+			break;
+
+		xil_printf("%08d   0x%08X %08d   0x%08X\n", entry->sequence,
+				(unsigned int)capture.data + entry->offset, entry->length, entry->timestamp);
+	}
+}
+
+/*****************************************************************************/
+/**
+ * @brief arm the capture trigger
+ * This function copies the trigger configuration, clears the ring and starts
+ * recording.  When the trigger fires the post-trigger window is recorded and
+ * then the ring is frozen, so the frames leading up to the event are kept.
+ *
+ * @param	config is a pointer to the trigger configuration
+ *
+ * @return	none
+ *
+ * @note 	preFrames only sets how much history is reported, everything still
+ * 			in the ring is kept
+ *
+******************************************************************************/
+void triggerArm(capture_trigger_struct *config) {
+
+	captureInit();
+
+	trigger = *config;
+	trigger.state = TRIGGER_ARMED;
+	trigger.cause = 0;
+	trigger.remaining = 0;
+	trigger.sequenceValid = 0;
+	trigger.linkErrors = 0;
+	trigger.dmaErrors = dmaErrorCount();
+
+	capture.enabled = 1;
+}
+
+/*****************************************************************************/
+/**
+ * @brief disarm the capture trigger
+ *
+ * @return	none
+ *
+ * @note 	recording continues without a trigger
+ *
+******************************************************************************/
+void triggerDisarm(void) {
+
+	trigger.state = TRIGGER_IDLE;
+}
+
+/*****************************************************************************/
+/**
+ * @brief poll the trigger sources that are not part of a frame
+ * This function checks the aurora error bits for a rising edge and the AXI
+ * DMA error count.  It costs one GPIO read so it can be called per frame.
+ *
+ * @param	p is a pointer to the parameters structure
+ *
+ * @return	none
+ *
+ * @note 	the error count is used rather than Error, which the recovery
+ * 			clears, so an error is seen however late the poll comes
+ *
+******************************************************************************/
+HOT_CODE void triggerPoll(params_struct *p) {
+
+	unsigned int statusRegister;
+	struct strSStatus *status = (struct strSStatus *)&statusRegister;
+	unsigned int linkErrors;
+
+	if(trigger.state != TRIGGER_ARMED)
+		return;
+
+	if(trigger.sources & TRIGGER_LINK_ERROR) {
+		statusRegister = *p->ptr_GpioStatusReg;
+
+		linkErrors = status->frame_err | (status->hard_err << 1);
+
+		if(linkErrors & ~trigger.linkErrors) {
+			trigger.linkErrors = linkErrors;
+			triggerFire(TRIGGER_LINK_ERROR, capture.sequence);
+			return;
+		}
+
+		trigger.linkErrors = linkErrors;
+	}
+
+	if((trigger.sources & TRIGGER_DMA_ERROR) && (dmaErrorCount() != trigger.dmaErrors))
+		triggerFire(TRIGGER_DMA_ERROR, capture.sequence);
+}
+
+/*****************************************************************************/
+/**
+ * @brief state of the capture trigger
+ *
+ * @return	TRIGGER_IDLE/ARMED/FIRED/FROZEN
+ *
+ * @note 	none
+ *
+******************************************************************************/
+unsigned int triggerState(void) {
+
+	return trigger.state;
+}
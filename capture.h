@@ -0,0 +1,90 @@
+/*
+ * @file capture.h
+ */
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include "common.h"
+
+/*
+ * trigger sources, OR'ed together
+ */
+#define TRIGGER_LINK_ERROR		0x01		// aurora frame_err/hard_err rising
+#define TRIGGER_DMA_ERROR		0x02		// AXI DMA error flag
+#define TRIGGER_SEQUENCE_GAP	0x04		// frame sequence word did not increment
+#define TRIGGER_HEADER_MATCH	0x08		// frame word matches a value
+
+/*
+ * trigger states
+ */
+#define TRIGGER_IDLE			0
+#define TRIGGER_ARMED			1			// waiting for an event
+#define TRIGGER_FIRED			2			// recording the post-trigger window
+#define TRIGGER_FROZEN			3			// ring frozen, recording stopped
+
+/**
+ * @struct capture_index_struct
+ * @brief per-frame capture index entry
+ */
+typedef struct capture_index_type {
+	unsigned int offset;				//!< offset of the frame from CAPTURE_BASE
+	unsigned int length;				//!< frame length in bytes
+	unsigned int timestamp;				//!< timer ticks when the frame was recorded
+	unsigned int sequence;				//!< capture sequence number
+} capture_index_struct;
+
+/**
+ * @struct capture_trigger_struct
+ * @brief capture trigger configuration and state
+ */
+typedef struct capture_trigger_type {
+	unsigned int sources;				//!< OR'ed trigger sources
+	unsigned int preFrames;				//!< frames kept before the trigger
+	unsigned int postFrames;			//!< frames recorded after the trigger
+	unsigned int sequenceWord;			//!< word in the frame holding a sequence count
+	unsigned int matchWord;				//!< word in the frame to compare
+	unsigned int matchMask;				//!< bits of the word to compare
+	unsigned int matchValue;			//!< value to compare against
+	unsigned int state;					//!< TRIGGER_IDLE/ARMED/FIRED/FROZEN
+	unsigned int cause;					//!< source that fired the trigger
+	unsigned int sequence;				//!< capture sequence number at the trigger
+	unsigned int remaining;				//!< post-trigger frames still to record
+	unsigned int lastSequence;			//!< last frame sequence word seen
+	unsigned int sequenceValid;			//!< 1 once lastSequence holds a value
+	unsigned int linkErrors;			//!< last frame_err/hard_err state
+	unsigned int dmaErrors;				//!< dmaErrorCount() when armed
+} capture_trigger_struct;
+
+/**
+ * @struct capture_struct
+ * @brief capture ring state
+ */
+typedef struct capture_type {
+	u8 *					data;				//!< start of the frame data ring
+	unsigned int			dataSize;			//!< size of the frame data ring in bytes
+	unsigned int			writeOffset;		//!< where the next frame is written
+	capture_index_struct *	index;				//!< start of the index ring
+	unsigned int			indexSize;			//!< number of index entries
+	unsigned int			head;				//!< next index entry to write
+	unsigned int			tail;				//!< oldest valid index entry
+	unsigned int			count;				//!< number of valid index entries
+	unsigned int			sequence;			//!< next sequence number
+	unsigned int			enabled;			//!< 1-recording
+	unsigned int			evicted;			//!< frames overwritten by newer frames
+} capture_struct;
+
+void captureInit(void);
+void captureEnable(int);
+int captureEnabled(void);
+void captureFrame(u8 *, unsigned int);
+capture_index_struct *captureGetEntry(unsigned int);
+unsigned int captureCount(void);
+u8 *captureGetFrame(capture_index_struct *);
+void displayCapture(unsigned int);
+void triggerArm(capture_trigger_struct *);
+void triggerDisarm(void);
+void triggerPoll(params_struct *);
+unsigned int triggerState(void);
+
+#endif /* CAPTURE_H_ */
@@ -14,8 +14,11 @@
 #include "xintc.h"
 #include "xaxidma.h"
 #include "xiic.h"
+#include "xtmrctr.h"
 #include "mb_interface.h"
 
+#include "rtsp_frame.h"
+
 
 /**
  * ************************ Constant Definitions ****************************
@@ -25,6 +28,17 @@
 
 #define printf xil_printf	/* A smaller footprint printf */
 
+/*
+ * code placement, see lscript.ld.  HOT_CODE is kept in local BRAM ahead of
+ * everything else, COLD_CODE runs from DDR out of the way of the hot path
+ * and is never inlined into a caller in BRAM.
+ * DDR_DATA puts data only the cold code reads in DDR next to it.  Tables
+ * the hot path reads stay in .bss in BRAM.
+ */
+#define HOT_CODE	__attribute__((section(".hot_text")))
+#define COLD_CODE	__attribute__((section(".cold_text"), noinline))
+#define DDR_DATA	__attribute__((section(".ddr_data")))
+
 #define BYTE_SEARCH 0
 #define WORD_SEARCH 1
 
@@ -59,6 +73,14 @@
 #define DDR_BASE	0x90000000
 #define DDR_HIGH	0x9FFFFFFF
 
+/*
+ * capture ring, frame data and the per-frame index
+ */
+#define CAPTURE_BASE			0xB0000000
+#define CAPTURE_HIGH			0xDFFFFFFF
+#define CAPTURE_INDEX_BASE		0xE0000000
+#define CAPTURE_INDEX_ENTRIES	0x00100000		// 16 bytes each
+
 // PCA9548 8-port IIC Switch
 #define IIC_SWITCH_ADDRESS 0x74
 // Connected to IIC Buses
@@ -110,10 +132,7 @@
 
 #define DMA_DEV_ID			XPAR_AXIDMA_0_DEVICE_ID
 
-#define DMA_TX_BUFFER_BASE	0xA0000000
-#define DMA_TX_BUFFER_HIGH	0xA01FFFFF
-#define DMA_RX_BUFFER_BASE	0xA0300000
-#define DMA_RX_BUFFER_HIGH	0xA04FFFFF
+#define DMA_BOUNCE_SIZE		0x00101000		// largest frame and its trailer, rounded to 4KB
 
 #define DMA_RX_INTR_ID		XPAR_MICROBLAZE_0_AXI_INTC_AXI_DMA_0_S2MM_INTROUT_INTR
 #define DMA_TX_INTR_ID		XPAR_MICROBLAZE_0_AXI_INTC_AXI_DMA_0_MM2S_INTROUT_INTR
@@ -122,6 +141,33 @@
 
 #define DMA_TEST_VALUES 0x100
 
+/*
+ * frame slots start on a FRAME_ALIGN boundary.  the sync word and header sit
+ * at the end of the first FRAME_HEADER_SLOT bytes so the payload starts on a
+ * cache line and burst boundary and the header has a line to itself.
+ */
+#define FRAME_ALIGN			64				// covers the cache line and an AXI burst
+#define FRAME_HEADER_SLOT	FRAME_ALIGN
+
+#define FORWARD_SLOTS		16
+#define FORWARD_SLOT_SIZE	(RTSP_MAX_FRAME_SIZE + 0x1000)	// room for a CRC trailer
+
+/*
+ * DDR regions the frame buffer pools are carved from, see pool.h
+ */
+#define HOST_POOL_BASE		0x80000000		// frames from the host and NWL loopback data
+#define HOST_POOL_SIZE		0x20000000
+#define HOST_BUFFER_SIZE	0x10000000		// keeps the buffers on the host's 0x80000000 and 0x90000000
+#define DMA_POOL_BASE		0xA0000000		// AXI DMA test buffers and one bounce buffer each way
+#define DMA_POOL_SIZE		0x00800000
+#define WORK_POOL_BASE		0xA0800000		// unpacked and decompressed frames for this shelf
+#define WORK_POOL_SIZE		0x00800000
+#define WORK_BUFFER_SIZE	(4 * RTSP_MAX_FRAME_SIZE)
+#define FORWARD_POOL_BASE	0xA1000000		// receive slots for forwarding
+#define FORWARD_POOL_SIZE	(FORWARD_SLOTS * FORWARD_SLOT_SIZE)
+
+#define TIMER_DEV_ID		XPAR_TMRCTR_0_DEVICE_ID
+#define TIMER_CLOCK_HZ		XPAR_TMRCTR_0_CLOCK_FREQ_HZ
 #define TIMER_INTR_ID		XPAR_MICROBLAZE_0_AXI_INTC_AXI_TIMER_0_INTERRUPT_INTR
 #define EXTERNAL_INTR_0_ID	XPAR_MICROBLAZE_0_AXI_INTC_SYSTEM_INTR_0_INTR
 #define UART_INTR_ID		XPAR_MICROBLAZE_0_AXI_INTC_AXI_UARTLITE_0_INTERRUPT_INTR
@@ -251,20 +297,6 @@ typedef struct dma_reg_struct_type {
 	unsigned char AXI_STATUS;		/**< default -  0x3f */
 } dma_reg_struct;
 
-typedef struct RTSP_FrameHeader_type {
-	unsigned int	headerID;
-	unsigned int	shelfID;
-	unsigned int	dataSize;
-} strRtspFrameHeader;
-
-typedef struct RTSP_ChannelHeader_type {
-	unsigned int channelNumber; //!< channel number
-	unsigned int channelSize;	//!< number of elements from here to the end of the channel
-	unsigned int W;				//!< number of ranges
-	unsigned int D[8];			//!< ranges
-	unsigned N[8];				//!< samples per range
-}strRtspChannelHeader;
-
 typedef struct params_type {
 	unsigned int			software_version;					//!< current software version
 	unsigned int			firmware_version;					//!< current firmware version
@@ -272,6 +304,7 @@ typedef struct params_type {
 	XIntc *					pInterruptController;				//!< pointer to interrupt controller
 	XIic *					pIicInstance;						//!< pointer to i2c controller
 	XAxiDma *				pAxiDma;							//!< pointer to AXI DMA controller
+	XTmrCtr *				pTimer;								//!< pointer to AXI timer
 	dma_reg_struct *		pDmaChannelRegisters[3];			//!< pointer to NWL DMA channel registers
 	unsigned int *			nwlDmaSlaveRegisterBase;			//!< pointer to NWL slave port
 	unsigned int 			dataSourceLocation;					//!< address of source data
@@ -279,6 +312,8 @@ typedef struct params_type {
 	u8 *					pRxBuffer;							//!< pointer to aurora rx buffer in memory
 	u8 *					pTxBuffer;							//!< pointer to aurora tx buffer in memory
 	unsigned int			testPacketSize;						//!< size of test packet from PC
+	unsigned int			headerID;							//!< expected RTSP headerID
+	unsigned int			shelfID;							//!< shelf ID of this board in the daisy chain
 	unsigned int *			ptr_GpioSidebandReg;				//!< pointer to hw address for the sideband register
 	unsigned int *			ptr_GpioIntrRxReg;					//!< pointer to hw address for the interrupt register
 	unsigned int *			ptr_GpioStatusReg;					//!< pointer to hw address for the status register
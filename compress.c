@@ -0,0 +1,441 @@
+/*
+ * @file compress.c
+ * @brief lossless delta compression of RTSP channels
+ */
+
+#include "compress.h"
+#include "pack.h"
+#include "rtsp.h"
+#include "cache.h"
+
+static compress_struct compress;
+
+/*****************************************************************************/
+/**
+ * @brief set up delta compression
+ * This function turns compression off and clears the counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+void compressInit(void) {
+
+	compress.enabled = 0;
+	compress.framesCompressed = 0;
+	compress.framesDecompressed = 0;
+	compress.channelsCompressed = 0;
+	compress.channelsRaw = 0;
+	compress.channelsBad = 0;
+	compress.wordsSaved = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief turn compression on or off
+ *
+ * @param	enable holds 1-compress, 0-send raw
+ *
+ * @return	none
+ *
+ * @note 	decompression on receive is always on
+ *
+******************************************************************************/
+void compressEnable(unsigned int enable) {
+
+	compress.enabled = enable;
+}
+
+/*****************************************************************************/
+/**
+ * @brief check if compression is on
+ *
+ * @return	1-on, 0-off
+ *
+ * @note 	none
+ *
+******************************************************************************/
+unsigned int compressEnabled(void) {
+
+	return compress.enabled;
+}
+
+/*****************************************************************************/
+/**
+ * @brief zigzag code the difference between two samples
+ * This function maps small differences of either sign to small numbers,
+ * 0, -1, 1, -2 .. become 0, 1, 2, 3 ..
+ *
+ * @param	sample holds the sample
+ * @param	previous holds the sample before it
+ *
+ * @return	zigzag coded difference
+ *
+ * @note 	none
+ *
+******************************************************************************/
+static inline unsigned int compressZigzag(unsigned int sample, unsigned int previous) {
+
+	unsigned int d = sample - previous;
+
+	return (d << 1) ^ (unsigned int)((int)d >> 31);
+}
+
+/*****************************************************************************/
+/**
+ * @brief number of varint bytes for a value
+ *
+ * @param	z holds the zigzag coded difference
+ *
+ * @return	1 to 5
+ *
+ * @note 	none
+ *
+******************************************************************************/
+static inline unsigned int compressBytes(unsigned int z) {
+
+	if(z < 0x00000080)
+		return 1;
+	if(z < 0x00004000)
+		return 2;
+	if(z < 0x00200000)
+		return 3;
+	if(z < 0x10000000)
+		return 4;
+
+	return 5;
+}
+
+/*****************************************************************************/
+/**
+ * @brief number of sample words in a channel
+ * This function adds up N[] over the ranges held in the low bits of W.  A
+ * packed channel holds its samples width bits apiece, so its words are
+ * worked out from the width packFrame() left in W.
+ *
+ * @param	channel is a pointer to the channel header
+ * @param	W holds the channel W without the compression mark
+ *
+ * @return	words of samples, 0xFFFFFFFF if the ranges or width are out of range
+ *
+ * @note 	packed words are delta coded as they are, unpackFrame() undoes
+ * 			the packing once they are decompressed
+ *
+******************************************************************************/
+HOT_CODE static unsigned int compressSamples(strRtspChannelHeader *channel, unsigned int W) {
+
+	unsigned int ranges = W & PACK_W_RANGES;
+	unsigned int width = (W & PACK_W_WIDTH_MASK) >> PACK_W_WIDTH_POS;
+	unsigned int samples = 0;
+	unsigned int i;
+
+	if(ranges > RTSP_MAX_RANGES)
+		return 0xFFFFFFFF;
+
+	for(i = 0; i < ranges; i++)
+		samples += channel->N[i];
+
+	if(width == PACK_OFF)
+		return samples;
+
+	if((width != PACK_16) && (width != PACK_24))
+		return 0xFFFFFFFF;
+
+	return ((samples * width) + 31) / 32;
+}
+
+/*****************************************************************************/
+/**
+ * @brief compress one channel
+ * This function sizes the coded channel first and only codes it if it comes
+ * out smaller and the coded bytes never get ahead of the samples still to be
+ * read.  That lets the channel be coded straight into dst, which is never
+ * past src, with no scratch buffer.  Otherwise the channel is copied raw.
+ *
+ * @param	src is a pointer to the channel header
+ * @param	dst is a pointer to where the channel goes
+ *
+ * @return	words written
+ *
+ * @note 	bytes are gathered a word at a time so DDR only sees word writes
+ *
+******************************************************************************/
+HOT_CODE static unsigned int compressChannel(strRtspChannelHeader *src, unsigned int *dst) {
+
+	unsigned int *in = (unsigned int *)src;
+	unsigned int *out;
+	unsigned int words = src->channelSize + 1;
+	unsigned int W = src->W;
+	unsigned int samples, bytes, coded, i;
+	unsigned int previous, sample, z, acc, bits;
+
+	samples = compressSamples(src, W);
+
+	if((samples != (words - RTSP_CHANNEL_HEADER_WORDS)) || (samples < 2))
+		goto raw;
+
+	/*
+	 * pass 1 - size it
+	 */
+	in += RTSP_CHANNEL_HEADER_WORDS;
+	previous = in[0];
+	bytes = 4;
+
+	for(i = 1; i < samples; i++) {
+		sample = in[i];
+		bytes += compressBytes(compressZigzag(sample, previous));
+		previous = sample;
+
+		if(bytes > ((i + 1) * 4))						// would overwrite unread samples
+			goto raw;
+	}
+
+	coded = (bytes + 3) / 4;
+
+	if(coded >= samples)
+		goto raw;
+
+	/*
+	 * pass 2 - code it
+	 */
+	in = (unsigned int *)src;
+	for(i = 0; i < RTSP_CHANNEL_HEADER_WORDS; i++)
+		dst[i] = in[i];
+
+	in += RTSP_CHANNEL_HEADER_WORDS;
+	out = dst + RTSP_CHANNEL_HEADER_WORDS;
+
+	previous = in[0];
+	*out++ = previous;
+	acc = 0;
+	bits = 0;
+
+	for(i = 1; i < samples; i++) {
+		sample = in[i];
+		z = compressZigzag(sample, previous);
+		previous = sample;
+
+		while(z >= 0x80) {
+			acc |= ((z & 0x7F) | 0x80) << bits;
+			z >>= 7;
+			bits += 8;
+			if(bits == 32) {
+				*out++ = acc;
+				acc = 0;
+				bits = 0;
+			}
+		}
+
+		acc |= z << bits;
+		bits += 8;
+		if(bits == 32) {
+			*out++ = acc;
+			acc = 0;
+			bits = 0;
+		}
+	}
+
+	if(bits)
+		*out++ = acc;
+
+	((strRtspChannelHeader *)dst)->W = W | COMPRESS_W_DELTA;
+	((strRtspChannelHeader *)dst)->channelSize = (RTSP_CHANNEL_HEADER_WORDS - 1) + coded;
+
+	compress.channelsCompressed++;
+
+	return RTSP_CHANNEL_HEADER_WORDS + coded;
+
+raw:
+	compress.channelsRaw++;
+
+	in = (unsigned int *)src;
+	if(dst != in) {
+		for(i = 0; i < words; i++)
+			dst[i] = in[i];
+	}
+
+	return words;
+}
+
+/*****************************************************************************/
+/**
+ * @brief decompress one channel
+ *
+ * @param	src is a pointer to the channel header
+ * @param	dst is a pointer to where the 32 bit channel goes
+ * @param	room holds the words free at dst
+ *
+ * @return	words written, RTSP_EXPAND_FULL if the channel would not fit
+ *
+ * @note 	a channel that is not coded, or runs out of words, is copied as it
+ * 			is.  N[] is checked against room before anything is written, a few
+ * 			words of zero byte varints can claim millions of samples.
+ *
+******************************************************************************/
+HOT_CODE static unsigned int decompressChannel(strRtspChannelHeader *src, unsigned int *dst, unsigned int room) {
+
+	unsigned int *in = (unsigned int *)src;
+	unsigned int *end = in + src->channelSize + 1;
+	unsigned int W = src->W;
+	unsigned int samples, i, z, shift, byte, acc, bits;
+	unsigned int previous;
+
+	if(!(W & COMPRESS_W_DELTA))
+		goto copy;
+
+	W &= ~COMPRESS_W_DELTA;
+	samples = compressSamples(src, W);
+
+	if((samples == 0xFFFFFFFF) || (samples < 2) || (src->channelSize < RTSP_CHANNEL_HEADER_WORDS))
+		goto bad;
+
+	if((room < RTSP_CHANNEL_HEADER_WORDS) || (samples > (room - RTSP_CHANNEL_HEADER_WORDS))) {
+		compress.channelsBad++;
+		return RTSP_EXPAND_FULL;
+	}
+
+	for(i = 0; i < RTSP_CHANNEL_HEADER_WORDS; i++)
+		dst[i] = in[i];
+
+	in += RTSP_CHANNEL_HEADER_WORDS;
+
+	previous = *in++;
+	dst[RTSP_CHANNEL_HEADER_WORDS] = previous;
+	acc = 0;
+	bits = 0;
+
+	for(i = 1; i < samples; i++) {
+		z = 0;
+		shift = 0;
+
+		do {
+			if(bits == 0) {
+				if(in == end)
+					goto bad;
+				acc = *in++;
+				bits = 32;
+			}
+			byte = acc & 0xFF;
+			acc >>= 8;
+			bits -= 8;
+
+			z |= (byte & 0x7F) << shift;
+			shift += 7;
+		} while((byte & 0x80) && (shift < 35));
+
+		previous += (z >> 1) ^ (0 - (z & 1));
+		dst[RTSP_CHANNEL_HEADER_WORDS + i] = previous;
+	}
+
+	((strRtspChannelHeader *)dst)->W = W;
+	((strRtspChannelHeader *)dst)->channelSize = (RTSP_CHANNEL_HEADER_WORDS - 1) + samples;
+
+	return RTSP_CHANNEL_HEADER_WORDS + samples;
+
+bad:
+	compress.channelsBad++;
+
+copy:
+	in = (unsigned int *)src;
+	if((unsigned int)(end - in) > room)
+		return RTSP_EXPAND_FULL;
+
+	for(i = 0; i < (unsigned int)(end - in); i++)
+		dst[i] = in[i];
+
+	return end - in;
+}
+
+/*****************************************************************************/
+/**
+ * @brief compress a frame in place
+ * This function delta codes every channel that gets smaller and closes up
+ * the gaps, so the frame can be sent from where it is
+ *
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	size holds the frame size in bytes
+ *
+ * @return	new frame size in bytes
+ *
+ * @note 	a changed frame is marked dirty for the next cacheCommit()
+ *
+******************************************************************************/
+HOT_CODE unsigned int compressFrame(u8 *frame, unsigned int size) {
+
+	unsigned int saved;
+
+	if(!compress.enabled)
+		return size;
+
+	saved = rtspShrinkFrame(frame, compressChannel);
+
+	if(saved == 0)
+		return size;
+
+	compress.framesCompressed++;
+	compress.wordsSaved += saved;
+
+	size = rtspFrameSize((strRtspFrameHeader *)(frame + RTSP_SYNC_SIZE));
+
+	cacheDirty(frame, size);
+
+	return size;
+}
+
+/*****************************************************************************/
+/**
+ * @brief decompress a received frame
+ * This function expands the delta coded channels of a frame back to 32 bit
+ * samples in a second buffer
+ *
+ * @param	src is a pointer to the start of the received frame (sync word)
+ * @param	dst is a pointer to the buffer for the decompressed frame
+ * @param	dstSize holds the bytes in dst
+ *
+ * @return	size of the decompressed frame in bytes, 0 if nothing was coded
+ * 			or the decompressed frame would not fit in dst
+ *
+ * @note 	when 0 is returned dst does not hold a frame, src is unchanged
+ *
+******************************************************************************/
+HOT_CODE unsigned int decompressFrame(u8 *src, u8 *dst, unsigned int dstSize) {
+
+	strRtspFrameHeader *header = (strRtspFrameHeader *)(src + RTSP_SYNC_SIZE);
+	strRtspChannelHeader *channel;
+	unsigned int size;
+
+	for(channel = rtspFirstChannel(header); channel != NULL; channel = rtspNextChannel(header, channel)) {
+		if(channel->W & COMPRESS_W_DELTA)
+			break;
+	}
+
+	if(channel == NULL)
+		return 0;
+
+	size = rtspExpandFrame(src, dst, dstSize, decompressChannel);
+	if(size)
+		compress.framesDecompressed++;
+
+	return size;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the compression counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayCompress(void) {
+
+	xil_printf("\nCompression \t\t- %s\n", compress.enabled ? "on" : "off");
+	xil_printf("Frames compressed \t- %d\n", compress.framesCompressed);
+	xil_printf("Frames decompressed \t- %d\n", compress.framesDecompressed);
+	xil_printf("Channels compressed \t- %d\n", compress.channelsCompressed);
+	xil_printf("Channels raw \t\t- %d\n", compress.channelsRaw);
+	xil_printf("Channels bad \t\t- %d\n", compress.channelsBad);
+	xil_printf("Words saved \t\t- %d\n", compress.wordsSaved);
+}
@@ -0,0 +1,38 @@
+/*
+ * @file compress.h
+ */
+
+#ifndef COMPRESS_H_
+#define COMPRESS_H_
+
+#include "common.h"
+
+/*
+ * a compressed channel is marked in W, next to the packing fields.  the first
+ * sample is sent as it is, the rest as zigzag varints of the difference from
+ * the sample before, 7 bits a byte, low byte of each word first.
+ */
+#define COMPRESS_W_DELTA	0x00008000
+
+/**
+ * @struct compress_struct
+ * @brief delta compression counters
+ */
+typedef struct compress_type {
+	unsigned int	enabled;				//!< 1-compress frames for the aurora
+	unsigned int	framesCompressed;		//!< frames made smaller
+	unsigned int	framesDecompressed;		//!< frames expanded on receive
+	unsigned int	channelsCompressed;		//!< channels sent delta coded
+	unsigned int	channelsRaw;			//!< channels where coding did not pay
+	unsigned int	channelsBad;			//!< coded channels that would not decode
+	unsigned int	wordsSaved;				//!< words taken off the aurora
+} compress_struct;
+
+void compressInit(void);
+void compressEnable(unsigned int);
+unsigned int compressEnabled(void);
+unsigned int compressFrame(u8 *, unsigned int);
+unsigned int decompressFrame(u8 *, u8 *, unsigned int);
+void displayCompress(void);
+
+#endif /* COMPRESS_H_ */
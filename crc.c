@@ -0,0 +1,214 @@
+/*
+ * @file crc.c
+ * @brief slice-by-8 CRC32 for end to end frame integrity
+ */
+
+#include "crc.h"
+#include "rtsp.h"
+#include "cache.h"
+
+static crc_struct crc;
+
+/*
+ * 8KB of tables, built at start up.  .bss is in local memory so each lookup
+ * is a single cycle BRAM read and does not compete with the frame for the
+ * data cache.
+ */
+static unsigned int crcTable[8][256];
+
+/*****************************************************************************/
+/**
+ * @brief set up the CRC
+ * This function builds the slice-by-8 tables.  Table 0 is the usual byte
+ * table, table n gives the effect of a byte n places further back.
+ *
+ * @return	none
+ *
+ * @note 	trailers are off until crcEnable()
+ *
+******************************************************************************/
+void crcInit(void) {
+
+	unsigned int i, k, c;
+
+	for(i = 0; i < 256; i++) {
+		c = i;
+		for(k = 0; k < 8; k++)
+			c = (c & 1) ? ((c >> 1) ^ CRC_POLYNOMIAL) : (c >> 1);
+		crcTable[0][i] = c;
+	}
+
+	for(i = 0; i < 256; i++) {
+		for(k = 1; k < 8; k++)
+			crcTable[k][i] = (crcTable[k - 1][i] >> 8) ^ crcTable[0][crcTable[k - 1][i] & 0xFF];
+	}
+
+	crc.enabled = 0;
+	crc.framesSigned = 0;
+	crc.framesUnsigned = 0;
+	crc.framesGood = 0;
+	crc.framesBad = 0;
+	crc.lastBad = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief turn transmit trailers on or off
+ *
+ * @param	enable holds 1-append, 0-send frames as they are
+ *
+ * @return	none
+ *
+ * @note 	received trailers are always checked
+ *
+******************************************************************************/
+void crcEnable(unsigned int enable) {
+
+	crc.enabled = enable;
+}
+
+/*****************************************************************************/
+/**
+ * @brief check if transmit trailers are on
+ *
+ * @return	1-on, 0-off
+ *
+ * @note 	none
+ *
+******************************************************************************/
+unsigned int crcEnabled(void) {
+
+	return crc.enabled;
+}
+
+/*****************************************************************************/
+/**
+ * @brief CRC32 of a buffer
+ * This function takes eight bytes a turn, two word loads and eight table
+ * lookups, once the data is word aligned
+ *
+ * @param	data is a pointer to the data
+ * @param	length holds the number of bytes
+ *
+ * @return	CRC32
+ *
+ * @note 	the word loads assume a little endian processor
+ *
+******************************************************************************/
+HOT_CODE unsigned int crc32(const u8 *data, unsigned int length) {
+
+	unsigned int c = 0xFFFFFFFF;
+	const unsigned int *w;
+	unsigned int one, two;
+
+	for(; length && ((u32)data & 3); length--)
+		c = (c >> 8) ^ crcTable[0][(c ^ *data++) & 0xFF];
+
+	w = (const unsigned int *)data;
+
+	for(; length >= 8; length -= 8) {
+		one = *w++ ^ c;
+		two = *w++;
+
+		c = crcTable[7][one & 0xFF] ^ crcTable[6][(one >> 8) & 0xFF] ^
+			crcTable[5][(one >> 16) & 0xFF] ^ crcTable[4][one >> 24] ^
+			crcTable[3][two & 0xFF] ^ crcTable[2][(two >> 8) & 0xFF] ^
+			crcTable[1][(two >> 16) & 0xFF] ^ crcTable[0][two >> 24];
+	}
+
+	data = (const u8 *)w;
+
+	for(; length; length--)
+		c = (c >> 8) ^ crcTable[0][(c ^ *data++) & 0xFF];
+
+	return ~c;
+}
+
+/*****************************************************************************/
+/**
+ * @brief append a CRC trailer to a frame
+ * This function adds the CRC of the whole frame, sync word included, after
+ * the last word
+ *
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	size holds the frame size in bytes
+ *
+ * @return	size to send in bytes
+ *
+ * @note 	the buffer needs 4 bytes of room past the frame
+ *
+******************************************************************************/
+HOT_CODE unsigned int crcAppend(u8 *frame, unsigned int size) {
+
+	if(!crc.enabled)
+		return size;
+
+	*(unsigned int *)(frame + size) = crc32(frame, size);
+
+	cacheDirty(frame + size, CRC_TRAILER_SIZE);
+
+	crc.framesSigned++;
+
+	return size + CRC_TRAILER_SIZE;
+}
+
+/*****************************************************************************/
+/**
+ * @brief check the CRC trailer of a received frame
+ * This function treats a frame one word longer than its header says as
+ * having a trailer.  A good trailer is taken off the size so the rest of the
+ * receive path sees the frame as it was sent.
+ *
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	size is a pointer to the bytes received
+ *
+ * @return	CRC_NONE/CRC_GOOD/CRC_BAD
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE int crcCheck(u8 *frame, unsigned int *size) {
+
+	unsigned int expected;
+	unsigned int length;
+
+	length = rtspFrameSize((strRtspFrameHeader *)(frame + RTSP_SYNC_SIZE));
+
+	if(*size != (length + CRC_TRAILER_SIZE)) {
+		crc.framesUnsigned++;
+		return CRC_NONE;
+	}
+
+	expected = *(unsigned int *)(frame + length);
+
+	if(crc32(frame, length) != expected) {
+		crc.framesBad++;
+		crc.lastBad = expected;
+		return CRC_BAD;
+	}
+
+	crc.framesGood++;
+	*size = length;
+
+	return CRC_GOOD;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the CRC counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayCrc(void) {
+
+	xil_printf("\nTransmit trailer \t- %s\n", crc.enabled ? "on" : "off");
+	xil_printf("Frames signed \t\t- %d\n", crc.framesSigned);
+	xil_printf("Frames unsigned \t- %d\n", crc.framesUnsigned);
+	xil_printf("Frames good \t\t- %d\n", crc.framesGood);
+	xil_printf("Frames bad \t\t- %d\n", crc.framesBad);
+	if(crc.framesBad)
+		xil_printf("Last bad trailer \t- 0x%08X\n", crc.lastBad);
+}
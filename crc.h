@@ -0,0 +1,38 @@
+/*
+ * @file crc.h
+ */
+
+#ifndef CRC_H_
+#define CRC_H_
+
+#include "common.h"
+
+#define CRC_POLYNOMIAL		0xEDB88320	// IEEE 802.3, reflected
+#define CRC_TRAILER_SIZE	4
+
+#define CRC_NONE			0			// frame has no trailer
+#define CRC_GOOD			1
+#define CRC_BAD				2
+
+/**
+ * @struct crc_struct
+ * @brief frame CRC settings and counters
+ */
+typedef struct crc_type {
+	unsigned int	enabled;			//!< 1-append a trailer on transmit
+	unsigned int	framesSigned;		//!< trailers appended
+	unsigned int	framesUnsigned;		//!< frames received without a trailer
+	unsigned int	framesGood;			//!< trailers that matched
+	unsigned int	framesBad;			//!< trailers that did not match
+	unsigned int	lastBad;			//!< CRC received on the last bad frame
+} crc_struct;
+
+void crcInit(void);
+void crcEnable(unsigned int);
+unsigned int crcEnabled(void);
+unsigned int crc32(const u8 *, unsigned int);
+unsigned int crcAppend(u8 *, unsigned int);
+int crcCheck(u8 *, unsigned int *);
+void displayCrc(void);
+
+#endif /* CRC_H_ */
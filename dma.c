@@ -7,7 +7,16 @@
  */
 
 #include "dma.h"
-#include "xil_cache.h"
+#include "pool.h"
+#include "cache.h"
+#include "timer.h"
+#include <string.h>
+
+static dma_bounce_struct bounce;
+static dma_poll_struct poll;
+static dma_recovery_struct recovery;
+static dma_watch_struct watch[DMA_WATCHES];
+static const char *watchNames[DMA_WATCHES] = {"MM2S", "S2MM", "Host"};
 
 /*****************************************************************************/
 /**
@@ -71,6 +80,36 @@ int initDMA( XAxiDma *dmaController, u8 *rxBuffer, u8 *txBuffer) {
 		return XST_FAILURE;
 	}
 
+	/*
+	 * without a DRE the engine can only start on a stream word boundary
+	 */
+	bounce.mm2sAlign = Config->HasMm2SDRE ? 1 : (Config->Mm2SDataWidth / 8);
+	bounce.s2mmAlign = Config->HasS2MmDRE ? 1 : (Config->S2MmDataWidth / 8);
+	bounce.rxBuffer = NULL;
+	bounce.rxBouncing = 0;
+	bounce.txBounced = 0;
+	bounce.rxBounced = 0;
+	bounce.tooLarge = 0;
+
+	/*
+	 * the bounce buffers are kept for good, a second init reuses them
+	 */
+	if(bounce.txBounce == NULL)
+		bounce.txBounce = poolAlloc(POOL_DMA);
+	if(bounce.rxBounce == NULL)
+		bounce.rxBounce = poolAlloc(POOL_DMA);
+
+	if((bounce.txBounce == NULL) || (bounce.rxBounce == NULL)) {
+		xil_printf("DMA: No bounce buffers\n");
+		return XST_FAILURE;
+	}
+
+	dmaPollSet(DMA_POLL_THRESHOLD, DMA_POLL_BUDGET_US);
+
+	dmaWatchdogSet(DMA_WATCH_MM2S, DMA_WATCH_MM2S_US);
+	dmaWatchdogSet(DMA_WATCH_S2MM, DMA_WATCH_S2MM_US);
+	dmaWatchdogSet(DMA_WATCH_HOST, DMA_WATCH_HOST_US);
+
 	return XST_SUCCESS;
 
 }
@@ -104,23 +143,11 @@ int sendDMA( params_struct *p) {
 	XAxiDma_IntrEnable(p->pAxiDma, XAXIDMA_IRQ_ALL_MASK,	XAXIDMA_DMA_TO_DEVICE);
 
 
-	/* Flush the SrcBuffer before the DMA transfer, in case the Data Cache
-	 * is enabled
-	 */
-	Xil_DCacheFlushRange((u32)p->pTxBuffer, p->testPacketSize);
-
-	status = XAxiDma_SimpleTransfer(p->pAxiDma, (u32) p->pTxBuffer, p->testPacketSize, XAXIDMA_DMA_TO_DEVICE);
-	if (status != XST_SUCCESS) {
+	status = dmaTransferWait(p->pAxiDma, p->pTxBuffer, p->testPacketSize, XAXIDMA_DMA_TO_DEVICE);
+	if ((status != XST_SUCCESS) && !Error) {
 		return XST_FAILURE;
 	}
 
-	/*
-	 * Wait TX done and RX done
-	 */
-	while (!TxDone && !Error) {
-			/* NOP */
-	}
-
 	if (Error) {
 		xil_printf("DMA ERROR -  transmit%s done, "
 		"receive%s done\r\n", TxDone? "":" not",
@@ -142,6 +169,8 @@ int sendDMA( params_struct *p) {
 	tmpAddr = (unsigned int *)(dmaController->RegBase+0x58);val = *(tmpAddr); xil_printf("0x%08X\t0x%08X\n",tmpAddr,val);
 #endif
 
+		dmaRecoverWait(p->pAxiDma);
+		return XST_FAILURE;
 	}
 
 	return XST_SUCCESS;
@@ -173,12 +202,13 @@ int receiveDMA( params_struct *p) {
 
 	XAxiDma_IntrEnable(p->pAxiDma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DEVICE_TO_DMA);
 
-	/* Flush the SrcBuffer before the DMA transfer, in case the Data Cache
-	 * is enabled
+	/*
+	 * the buffer may hold CPU writes nobody marked, drop them so they
+	 * cannot be written back over the received data
 	 */
-	Xil_DCacheFlushRange((u32)p->pRxBuffer, p->testPacketSize + 1);
+	cacheInvalidate(p->pRxBuffer, p->testPacketSize + 1);
 
-	status = XAxiDma_SimpleTransfer(p->pAxiDma,(u32) p->pRxBuffer, p->testPacketSize + 1, XAXIDMA_DEVICE_TO_DMA);
+	status = dmaTransfer(p->pAxiDma, p->pRxBuffer, p->testPacketSize + 1, XAXIDMA_DEVICE_TO_DMA);
 	if (status != XST_SUCCESS) {
 		return XST_FAILURE;
 	}
@@ -201,7 +231,7 @@ int receiveDMA( params_struct *p) {
  * @note 	none
  *
 ******************************************************************************/
-void displayDmaRegisters(XAxiDma *dmaController) {
+COLD_CODE void displayDmaRegisters(XAxiDma *dmaController) {
 
 	unsigned int *tmpAddr;
 	unsigned int val;
@@ -231,7 +261,7 @@ void displayDmaRegisters(XAxiDma *dmaController) {
  * @note 	none
  *
 ******************************************************************************/
-unsigned int getDmaBytesReceived(XAxiDma *dmaController) {
+HOT_CODE unsigned int getDmaBytesReceived(XAxiDma *dmaController) {
 	unsigned int *tmpAddr;
 	unsigned int val;
 
@@ -240,3 +270,598 @@ unsigned int getDmaBytesReceived(XAxiDma *dmaController) {
 	return val;
 
 }
+
+/*****************************************************************************/
+/**
+ * @brief start a simple transfer, bouncing it if it is not aligned
+ * This function hands an aligned buffer straight to the engine.  Without a
+ * DRE the engine cannot start part way into a stream word, so an unaligned
+ * transmit is copied into an aligned bounce buffer first and an unaligned
+ * receive lands in one and is copied out by dmaReceiveComplete().
+ *
+ * @param	dmaController holds a pointer to the DMA controller instance
+ * @param	buffer holds a pointer to the data
+ * @param	length holds the number of bytes
+ * @param	direction holds XAXIDMA_DMA_TO_DEVICE or XAXIDMA_DEVICE_TO_DMA
+ *
+ * @return	success/failure
+ *
+ * @note 	pending dirty ranges are flushed before a transmit starts, a
+ * 			bounced transmit buffer can be reused as soon as this returns
+ *
+******************************************************************************/
+HOT_CODE int dmaTransfer(XAxiDma *dmaController, u8 *buffer, unsigned int length, int direction) {
+
+	u8 *bounceBuffer;
+	unsigned int align;
+
+	align = (direction == XAXIDMA_DMA_TO_DEVICE) ? bounce.mm2sAlign : bounce.s2mmAlign;
+
+	if(direction == XAXIDMA_DEVICE_TO_DMA) {
+		bounce.rxBuffer = buffer;
+		bounce.rxBouncing = 0;
+	}
+
+	if((align <= 1) || !((u32)buffer & (align - 1))) {
+		if(direction == XAXIDMA_DMA_TO_DEVICE)
+			cacheCommit();
+		else
+			cacheReceive(buffer, length);
+
+		return XAxiDma_SimpleTransfer(dmaController, (u32) buffer, length, direction);
+	}
+
+	if(length > DMA_BOUNCE_SIZE) {
+		bounce.tooLarge++;
+		return XST_FAILURE;
+	}
+
+	if(XAxiDma_Busy(dmaController, direction))				// do not copy over a transfer in flight
+		return XST_FAILURE;
+
+	if(direction == XAXIDMA_DMA_TO_DEVICE) {
+		bounceBuffer = bounce.txBounce;
+
+		memcpy(bounceBuffer, buffer, length);
+		cacheFlush(bounceBuffer, length);
+
+		bounce.txBounced++;
+	} else {
+		bounceBuffer = bounce.rxBounce;
+
+		cacheReceive(bounceBuffer, length);
+
+		bounce.rxBouncing = 1;
+		bounce.rxBounced++;
+	}
+
+	return XAxiDma_SimpleTransfer(dmaController, (u32) bounceBuffer, length, direction);
+}
+
+/*****************************************************************************/
+/**
+ * @brief finish a receive
+ * This function returns the number of bytes received and leaves them ready
+ * to read in the buffer given to dmaTransfer(), invalidated from the cache,
+ * or copied out of the bounce buffer
+ *
+ * @param	dmaController holds a pointer to the DMA controller instance
+ *
+ * @return	bytes received
+ *
+ * @note 	call once RxDone is set, the caller does no cache maintenance
+ *
+******************************************************************************/
+HOT_CODE unsigned int dmaReceiveComplete(XAxiDma *dmaController) {
+
+	unsigned int length;
+	u8 *bounceBuffer = bounce.rxBounce;
+
+	length = getDmaBytesReceived(dmaController);
+
+	if(bounce.rxBouncing) {
+		cacheInvalidate(bounceBuffer, length);
+		memcpy(bounce.rxBuffer, bounceBuffer, length);
+		cacheDirty(bounce.rxBuffer, length);			// settled when the buffer is next armed
+		bounce.rxBouncing = 0;
+	} else if(bounce.rxBuffer != NULL)
+		cacheInvalidate(bounce.rxBuffer, length);
+
+	return length;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the bounce buffer counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayDmaBounce(void) {
+
+	xil_printf("\nDMA alignment 		- MM2S %d, S2MM %d\n", bounce.mm2sAlign, bounce.s2mmAlign);
+	xil_printf("Transmits bounced 	- %d\n", bounce.txBounced);
+	xil_printf("Receives bounced 	- %d\n", bounce.rxBounced);
+	xil_printf("Too large to bounce 	- %d\n", bounce.tooLarge);
+}
+
+/*****************************************************************************/
+/**
+ * @brief set the polled completion threshold
+ *
+ * @param	threshold holds the largest transfer in bytes that is polled, 0
+ * 			sends every transfer through the interrupt
+ * @param	budgetUs holds how long to poll before handing over to the
+ * 			interrupt
+ *
+ * @return	none
+ *
+ * @note 	the latency counters are cleared
+ *
+******************************************************************************/
+void dmaPollSet(unsigned int threshold, unsigned int budgetUs) {
+
+	int i;
+
+	poll.threshold = threshold;
+	poll.budgetUs = budgetUs;
+	poll.overBudget = 0;
+
+	for(i = 0; i < DMA_MODES; i++) {
+		poll.latency[i].transfers = 0;
+		poll.latency[i].bytes = 0;
+		poll.latency[i].totalTicks = 0;
+		poll.latency[i].maxTicks = 0;
+	}
+}
+
+/*****************************************************************************/
+/**
+ * @brief run a simple transfer to completion
+ * This function polls the status register for a transfer at or below the
+ * threshold, with its completion interrupt masked, so a small transfer does
+ * not pay for the interrupt entry and the TxDone/RxDone handshake.  A polled
+ * transfer still running when the budget is spent, and any larger transfer,
+ * waits for the interrupt handler.
+ *
+ * @param	dmaController holds a pointer to the DMA controller instance
+ * @param	buffer holds a pointer to the data
+ * @param	length holds the number of bytes
+ * @param	direction holds XAXIDMA_DMA_TO_DEVICE or XAXIDMA_DEVICE_TO_DMA
+ *
+ * @return	success/failure, Error is set if the engine reported one or the
+ * 			transfer missed its watchdog deadline
+ *
+ * @note 	the caller enables the channel interrupts, a receive is finished
+ * 			with dmaReceiveComplete()
+ *
+******************************************************************************/
+HOT_CODE int dmaTransferWait(XAxiDma *dmaController, u8 *buffer, unsigned int length, int direction) {
+
+	volatile int *done = (direction == XAXIDMA_DMA_TO_DEVICE) ? &TxDone : &RxDone;
+	int mode = (length <= poll.threshold) ? DMA_MODE_POLLED : DMA_MODE_INTERRUPT;
+	dma_latency_struct *latency = &poll.latency[mode];
+	int w = (direction == XAXIDMA_DMA_TO_DEVICE) ? DMA_WATCH_MM2S : DMA_WATCH_S2MM;
+	int status;
+	unsigned int start, ticks, budget;
+	u32 irq = 0;
+
+	*done = 0;
+
+	if(mode == DMA_MODE_POLLED)
+		XAxiDma_IntrDisable(dmaController, XAXIDMA_IRQ_IOC_MASK, direction);
+
+	start = timerGetTicks();
+
+	if(dmaTransfer(dmaController, buffer, length, direction) != XST_SUCCESS) {
+		if(mode == DMA_MODE_POLLED)
+			XAxiDma_IntrEnable(dmaController, XAXIDMA_IRQ_IOC_MASK, direction);
+		return XST_FAILURE;
+	}
+
+	dmaWatchdogArm(w);
+
+	if(mode == DMA_MODE_POLLED) {
+		budget = poll.budgetUs * TIMER_TICKS_PER_US;
+
+		do {
+			irq = XAxiDma_IntrGetIrq(dmaController, direction);
+		} while(!(irq & XAXIDMA_IRQ_IOC_MASK) && !Error && ((timerGetTicks() - start) < budget));
+
+		if(irq & XAXIDMA_IRQ_IOC_MASK) {
+			XAxiDma_IntrAckIrq(dmaController, XAXIDMA_IRQ_IOC_MASK, direction);
+			*done = 1;
+		} else if(!Error)
+			poll.overBudget++;
+
+		XAxiDma_IntrEnable(dmaController, XAXIDMA_IRQ_IOC_MASK, direction);		// a late completion interrupts now
+	}
+
+	status = dmaWait(w, done);
+	if(status != XST_SUCCESS)
+		return status;
+
+	ticks = timerGetTicks() - start;
+
+	latency->transfers++;
+	latency->bytes += length;
+	latency->totalTicks += ticks;
+	if(ticks > latency->maxTicks)
+		latency->maxTicks = ticks;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the polled completion settings and latency counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayDmaPoll(void) {
+
+	int i;
+	dma_latency_struct *latency;
+
+	xil_printf("\nPolled completion \t- up to %d bytes, %d us budget, %d handed over\n",
+			poll.threshold, poll.budgetUs, poll.overBudget);
+
+	for(i = 0; i < DMA_MODES; i++) {
+		latency = &poll.latency[i];
+
+		xil_printf("%s \t\t- %d transfers", (i == DMA_MODE_POLLED) ? "Polled" : "Interrupt", latency->transfers);
+		if(latency->transfers)
+			xil_printf(", %d bytes avg, %d ns avg, %d ns max", (u32)(latency->bytes / latency->transfers),
+					(u32)((latency->totalTicks * 1000) / ((u64)latency->transfers * TIMER_TICKS_PER_US)),
+					(u32)(((u64)latency->maxTicks * 1000) / TIMER_TICKS_PER_US));
+		xil_printf("\n");
+	}
+}
+
+/*****************************************************************************/
+/**
+ * @brief record an engine error
+ * This function is called from the interrupt handlers.  It only counts the
+ * error and raises Error, the reset is left to dmaRecover().
+ *
+ * @param	direction holds XAXIDMA_DMA_TO_DEVICE or XAXIDMA_DEVICE_TO_DMA
+ * @param	irqStatus holds the interrupt status bits read by the handler
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE void dmaErrorRaise(int direction, u32 irqStatus) {
+
+	if(direction == XAXIDMA_DMA_TO_DEVICE)
+		recovery.txErrors++;
+	else
+		recovery.rxErrors++;
+
+	recovery.lastStatus = irqStatus;
+
+	Error = 1;
+}
+
+/*****************************************************************************/
+/**
+ * @brief issue an engine reset
+ * This function resets both channels and lets dmaRecover() wait for it
+ *
+ * @param	dmaController holds a pointer to the DMA controller instance
+ *
+ * @return	none
+ *
+ * @note 	any transfer in flight is lost
+ *
+******************************************************************************/
+void dmaRecoveryStart(XAxiDma *dmaController) {
+
+	if(recovery.state != DMA_RECOVERY_RESET) {
+		recovery.tries = 0;
+		recovery.errorTicks = timerGetTicks();
+	}
+
+	XAxiDma_Reset(dmaController);
+
+	recovery.startTicks = timerGetTicks();
+	recovery.tries++;
+	recovery.resets++;
+	recovery.state = DMA_RECOVERY_RESET;
+}
+
+/*****************************************************************************/
+/**
+ * @brief take one step of error recovery
+ * This function never blocks.  An error starts a reset, and each call checks
+ * whether it has finished.  A reset that does not finish within
+ * DMA_RESET_TIMEOUT_US is issued again, up to DMA_RESET_TRIES times.  When
+ * the reset finishes the channel interrupts are enabled again, Error is
+ * cleared and DMA_RECOVERY_READY is returned once so the owner can re-arm
+ * the transfers it lost.
+ *
+ * @param	dmaController holds a pointer to the DMA controller instance
+ *
+ * @return	DMA_RECOVERY_IDLE/RESET/READY/FAILED
+ *
+ * @note 	call from the main loop while Error is set
+ *
+******************************************************************************/
+HOT_CODE int dmaRecover(XAxiDma *dmaController) {
+
+	unsigned int now, us;
+
+	switch(recovery.state) {
+
+		case DMA_RECOVERY_IDLE:
+			if(Error)
+				dmaRecoveryStart(dmaController);
+			break;
+
+		case DMA_RECOVERY_RESET:
+			now = timerGetTicks();
+
+			if(XAxiDma_ResetIsDone(dmaController)) {
+				XAxiDma_IntrEnable(dmaController, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DMA_TO_DEVICE);
+				XAxiDma_IntrEnable(dmaController, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DEVICE_TO_DMA);
+
+				TxDone = 0;
+				RxDone = 0;
+
+				if(Error) {
+					Error = 0;
+					recovery.recoveries++;
+
+					us = (now - recovery.errorTicks) / TIMER_TICKS_PER_US;
+					if(us > recovery.maxRecoveryUs)
+						recovery.maxRecoveryUs = us;
+				}
+
+				recovery.state = DMA_RECOVERY_IDLE;
+				return DMA_RECOVERY_READY;
+			}
+
+			if((now - recovery.startTicks) >= DMA_RESET_TIMEOUT_US * TIMER_TICKS_PER_US) {
+				recovery.resetTimeouts++;
+
+				if(recovery.tries < DMA_RESET_TRIES)
+					dmaRecoveryStart(dmaController);
+				else {
+					recovery.failures++;
+					recovery.state = DMA_RECOVERY_FAILED;
+				}
+			}
+			break;
+
+		case DMA_RECOVERY_FAILED:
+			break;
+	}
+
+	return recovery.state;
+}
+
+/*****************************************************************************/
+/**
+ * @brief run error recovery to the end
+ * This function is for callers with nothing else to do, the wait is bounded
+ * by DMA_RESET_TRIES * DMA_RESET_TIMEOUT_US
+ *
+ * @param	dmaController holds a pointer to the DMA controller instance
+ *
+ * @return	success/failure
+ *
+ * @note 	a failed engine is given a fresh set of tries
+ *
+******************************************************************************/
+int dmaRecoverWait(XAxiDma *dmaController) {
+
+	int state;
+
+	if(recovery.state == DMA_RECOVERY_FAILED)
+		recovery.state = DMA_RECOVERY_IDLE;
+
+	if(recovery.state == DMA_RECOVERY_IDLE)
+		dmaRecoveryStart(dmaController);
+
+	do {
+		state = dmaRecover(dmaController);
+	} while(state == DMA_RECOVERY_RESET);
+
+	return (state == DMA_RECOVERY_FAILED) ? XST_FAILURE : XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief number of engine errors seen
+ *
+ * @return	MM2S and S2MM errors since power up
+ *
+ * @note 	the count is not cleared by a recovery, so it still shows an
+ * 			error after Error has been cleared
+ *
+******************************************************************************/
+HOT_CODE unsigned int dmaErrorCount(void) {
+
+	return recovery.txErrors + recovery.rxErrors;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the error recovery counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayDmaRecovery(void) {
+
+	static const char *states[] = {"running", "resetting", "ready", "FAILED"};
+
+	xil_printf("\nDMA engine \t\t- %s\n", states[recovery.state]);
+	xil_printf("DMA errors \t\t- %d MM2S, %d S2MM, last status 0x%08X\n",
+			recovery.txErrors, recovery.rxErrors, recovery.lastStatus);
+	xil_printf("DMA resets \t\t- %d, %d timed out\n", recovery.resets, recovery.resetTimeouts);
+	xil_printf("DMA recoveries \t\t- %d, %d failed, %d us longest\n",
+			recovery.recoveries, recovery.failures, recovery.maxRecoveryUs);
+}
+
+/*****************************************************************************/
+/**
+ * @brief set a watchdog deadline
+ *
+ * @param	w holds DMA_WATCH_MM2S/S2MM/HOST
+ * @param	deadlineUs holds the time a transfer is allowed, 0 - no deadline
+ *
+ * @return	none
+ *
+ * @note 	the deadline is cut to what the timer can count before it wraps,
+ * 			the counters are cleared
+ *
+******************************************************************************/
+void dmaWatchdogSet(int w, unsigned int deadlineUs) {
+
+	if(deadlineUs > 0xFFFFFFFF / TIMER_TICKS_PER_US)
+		deadlineUs = 0xFFFFFFFF / TIMER_TICKS_PER_US;
+
+	watch[w].deadlineUs = deadlineUs;
+	watch[w].armed = 0;
+	watch[w].waits = 0;
+	watch[w].timeouts = 0;
+	watch[w].maxUs = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief start watching a transfer
+ *
+ * @param	w holds DMA_WATCH_MM2S/S2MM/HOST
+ *
+ * @return	none
+ *
+ * @note 	call as the transfer is started
+ *
+******************************************************************************/
+HOT_CODE void dmaWatchdogArm(int w) {
+
+	watch[w].startTicks = timerGetTicks();
+	watch[w].armed = 1;
+	watch[w].waits++;
+}
+
+/*****************************************************************************/
+/**
+ * @brief stop watching a transfer that has finished
+ *
+ * @param	w holds DMA_WATCH_MM2S/S2MM/HOST
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE void dmaWatchdogDisarm(int w) {
+
+	unsigned int us;
+
+	if(!watch[w].armed)
+		return;
+
+	watch[w].armed = 0;
+
+	us = (timerGetTicks() - watch[w].startTicks) / TIMER_TICKS_PER_US;
+	if(us > watch[w].maxUs)
+		watch[w].maxUs = us;
+}
+
+/*****************************************************************************/
+/**
+ * @brief check a watched transfer against its deadline
+ * This function never blocks, so a loop with other work to do can call it
+ * each pass.  A transfer past its deadline is counted, reported and no
+ * longer watched.
+ *
+ * @param	w holds DMA_WATCH_MM2S/S2MM/HOST
+ *
+ * @return	1-the deadline has passed, 0-otherwise
+ *
+ * @note 	the caller cancels an AXI DMA transfer by raising Error, the
+ * 			recovery reset stops the engine
+ *
+******************************************************************************/
+HOT_CODE int dmaWatchdogExpired(int w) {
+
+	dma_watch_struct *d = &watch[w];
+
+	if(!d->armed || !d->deadlineUs)
+		return 0;
+
+	if((timerGetTicks() - d->startTicks) < d->deadlineUs * TIMER_TICKS_PER_US)
+		return 0;
+
+	d->armed = 0;
+	d->timeouts++;
+
+	xil_printf("\nDMA TIMEOUT - %s transfer cancelled after %d us\n", watchNames[w], d->deadlineUs);
+
+	return 1;
+}
+
+/*****************************************************************************/
+/**
+ * @brief wait for a watched transfer to finish
+ * This function replaces the open ended spins on TxDone, RxDone and
+ * nwlInterruptFlag.  An AXI DMA transfer that misses its deadline raises
+ * Error so the caller's error path resets the engine, which cancels it.
+ *
+ * @param	w holds DMA_WATCH_MM2S/S2MM/HOST
+ * @param	flag is a pointer to the flag the interrupt handler sets
+ *
+ * @return	success/failure
+ *
+ * @note 	the transfer must have been armed with dmaWatchdogArm(), the
+ * 			host wait does not look at Error as the AXI DMA is not involved
+ *
+******************************************************************************/
+HOT_CODE int dmaWait(int w, volatile int *flag) {
+
+	int engine = (w != DMA_WATCH_HOST);
+
+	while(!*flag && !(engine && Error)) {
+		if(dmaWatchdogExpired(w)) {
+			if(engine)
+				Error = 1;
+			return XST_FAILURE;
+		}
+	}
+
+	dmaWatchdogDisarm(w);
+
+	return (engine && Error) ? XST_FAILURE : XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the watchdog deadlines and counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayDmaWatchdog(void) {
+
+	int i;
+
+	xil_printf("\nWatchdog\tDeadline (us)\tWaits\tTimeouts\tLongest (us)\n");
+
+	for(i = 0; i < DMA_WATCHES; i++)
+		xil_printf("%s\t\t%d\t\t%d\t%d\t\t%d\n", watchNames[i], watch[i].deadlineUs,
+				watch[i].waits, watch[i].timeouts, watch[i].maxUs);
+}
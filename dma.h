@@ -11,10 +11,126 @@
 #include "xaxidma.h"
 #include "common.h"
 
+#define DMA_MODE_POLLED		0			// completion found by reading the status register
+#define DMA_MODE_INTERRUPT	1			// completion found by the interrupt handler
+#define DMA_MODES			2
+
+#define DMA_POLL_THRESHOLD	4096		// default largest polled transfer in bytes
+#define DMA_POLL_BUDGET_US	50			// default time to poll before handing over to the interrupt
+
+#define DMA_RECOVERY_IDLE		0		// engine running
+#define DMA_RECOVERY_RESET		1		// reset issued, waiting for it to finish
+#define DMA_RECOVERY_READY		2		// reset finished, the owner re-arms its transfers
+#define DMA_RECOVERY_FAILED		3		// reset did not finish in DMA_RESET_TRIES tries
+
+#define DMA_RESET_TIMEOUT_US	1000	// time allowed for one reset
+#define DMA_RESET_TRIES			3
+
+#define DMA_WATCH_MM2S			0		// transmit in flight
+#define DMA_WATCH_S2MM			1		// receive being waited on
+#define DMA_WATCH_HOST			2		// frame from the host over the NWL DMA
+#define DMA_WATCHES				3
+
+#define DMA_WATCH_MM2S_US		10000	// default deadlines, 0 - no deadline
+#define DMA_WATCH_S2MM_US		100000
+#define DMA_WATCH_HOST_US		10000000
+
+/**
+ * @struct dma_bounce_struct
+ * @brief alignment the engine needs and the bounce counters
+ */
+typedef struct dma_bounce_type {
+	unsigned int	mm2sAlign;			//!< source alignment in bytes, 1 with a DRE
+	unsigned int	s2mmAlign;			//!< destination alignment in bytes, 1 with a DRE
+	u8 *			txBounce;			//!< bounce buffer for MM2S
+	u8 *			rxBounce;			//!< bounce buffer for S2MM
+	u8 *			rxBuffer;			//!< where the last receive goes
+	unsigned int	rxBouncing;			//!< 1-the last receive went to the bounce buffer
+	unsigned int	txBounced;			//!< transmits copied through the bounce buffer
+	unsigned int	rxBounced;			//!< receives copied through the bounce buffer
+	unsigned int	tooLarge;			//!< unaligned transfers too big to bounce
+} dma_bounce_struct;
+
+/**
+ * @struct dma_latency_struct
+ * @brief start to completion times for one completion mode
+ */
+typedef struct dma_latency_type {
+	unsigned int	transfers;
+	u64				bytes;				//!< 64 bits, 32 wraps after 4GB
+	u64				totalTicks;			//!< 64 bits, 32 wraps in under a minute
+	unsigned int	maxTicks;
+} dma_latency_struct;
+
+/**
+ * @struct dma_recovery_struct
+ * @brief error recovery state and counters
+ *
+ * the interrupt handlers only record an error, the reset is run from the
+ * main loop by dmaRecover() so a reset that never finishes cannot hang the
+ * handler
+ */
+typedef struct dma_recovery_type {
+	unsigned int	state;				//!< DMA_RECOVERY_IDLE/RESET/READY/FAILED
+	unsigned int	startTicks;			//!< when the current reset was issued
+	unsigned int	errorTicks;			//!< when the error was picked up
+	unsigned int	tries;				//!< resets issued for this recovery
+	u32				lastStatus;			//!< status bits of the last error
+	unsigned int	txErrors;			//!< MM2S errors
+	unsigned int	rxErrors;			//!< S2MM errors
+	unsigned int	resets;				//!< resets issued
+	unsigned int	resetTimeouts;		//!< resets that did not finish in time
+	unsigned int	recoveries;			//!< errors recovered from
+	unsigned int	failures;			//!< errors not recovered from
+	unsigned int	maxRecoveryUs;		//!< longest error to ready time
+} dma_recovery_struct;
+
+/**
+ * @struct dma_watch_struct
+ * @brief deadline and counters for one kind of outstanding transfer
+ */
+typedef struct dma_watch_type {
+	unsigned int	deadlineUs;			//!< time allowed, 0 - no deadline
+	unsigned int	armed;				//!< 1-a transfer is being watched
+	unsigned int	startTicks;			//!< when it was started
+	unsigned int	waits;				//!< transfers watched
+	unsigned int	timeouts;			//!< transfers cancelled at the deadline
+	unsigned int	maxUs;				//!< longest transfer that finished
+} dma_watch_struct;
+
+/**
+ * @struct dma_poll_struct
+ * @brief polled completion settings and latency counters
+ */
+typedef struct dma_poll_type {
+	unsigned int		threshold;				//!< largest polled transfer, 0 never polls
+	unsigned int		budgetUs;				//!< time to poll before handing over to the interrupt
+	unsigned int		overBudget;				//!< polled transfers handed over to the interrupt
+	dma_latency_struct	latency[DMA_MODES];
+} dma_poll_struct;
+
 int receiveDMA( params_struct *);
 int initDMA( XAxiDma *dmaController, u8 *rxBuffer, u8 *txBuffer);
 int sendDMA( params_struct *);
 void displayDmaRegisters(XAxiDma *dmaController);
 unsigned int getDmaBytesReceived(XAxiDma *dmaController);
+int dmaTransfer(XAxiDma *dmaController, u8 *buffer, unsigned int length, int direction);
+unsigned int dmaReceiveComplete(XAxiDma *dmaController);
+void displayDmaBounce(void);
+void dmaPollSet(unsigned int, unsigned int);
+int dmaTransferWait(XAxiDma *dmaController, u8 *buffer, unsigned int length, int direction);
+void displayDmaPoll(void);
+void dmaErrorRaise(int, u32);
+void dmaRecoveryStart(XAxiDma *dmaController);
+int dmaRecover(XAxiDma *dmaController);
+int dmaRecoverWait(XAxiDma *dmaController);
+unsigned int dmaErrorCount(void);
+void displayDmaRecovery(void);
+void dmaWatchdogSet(int, unsigned int);
+void dmaWatchdogArm(int);
+void dmaWatchdogDisarm(int);
+int dmaWatchdogExpired(int);
+int dmaWait(int, volatile int *);
+void displayDmaWatchdog(void);
 
 #endif /* DMA_H_ */
@@ -0,0 +1,153 @@
+/*
+ * @file filter.c
+ * @brief early-drop frame filter
+ */
+
+#include "filter.h"
+#include "rtsp.h"
+
+static filter_rule_struct filterRules[FILTER_MAX_RULES];
+static unsigned int filterRuleCount;
+static unsigned int filterPassed;
+static unsigned int filterDropped;
+
+/*****************************************************************************/
+/**
+ * @brief clear the filter
+ * This function removes all rules, an empty filter passes every frame
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+void filterInit(void) {
+
+	filterRuleCount = 0;
+	filterPassed = 0;
+	filterDropped = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief add a filter rule
+ *
+ * @param	rule is a pointer to the rule to copy into the filter
+ *
+ * @return	success/failure
+ *
+ * @note 	none
+ *
+******************************************************************************/
+int filterAddRule(filter_rule_struct *rule) {
+
+	if(filterRuleCount >= FILTER_MAX_RULES)
+		return XST_FAILURE;
+
+	filterRules[filterRuleCount] = *rule;
+	filterRules[filterRuleCount].hits = 0;
+	filterRuleCount++;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief check a channel mask against the channels in a frame
+ *
+ * @param	header is a pointer to the RTSP frame header
+ * @param	mask holds the accepted channels
+ *
+ * @return	1 if any channel is accepted, 0 otherwise
+ *
+ * @note 	channels above 31 are only accepted by FILTER_ALL_CHANNELS
+ *
+******************************************************************************/
+HOT_CODE static int filterChannels(strRtspFrameHeader *header, unsigned int mask) {
+
+	strRtspChannelHeader *channel;
+
+	if(mask == FILTER_ALL_CHANNELS)
+		return 1;
+
+	channel = rtspFirstChannel(header);
+
+	while(channel != NULL) {
+		if((channel->channelNumber < 32) && (mask & (1 << channel->channelNumber)))
+			return 1;
+
+		channel = rtspNextChannel(header, channel);
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief filter a frame
+ * This function checks a frame header against the rules before any DMA is
+ * started.  A frame passes when it matches any rule.  The header predicates
+ * are checked first so the channel walk only runs for frames that could pass.
+ *
+ * @param	header is a pointer to the RTSP frame header
+ *
+ * @return	1-pass, 0-drop
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE int filterFrame(strRtspFrameHeader *header) {
+
+	unsigned int i;
+	filter_rule_struct *rule;
+
+	if(filterRuleCount == 0)
+		return 1;
+
+	for(i = 0; i < filterRuleCount; i++) {
+		rule = &filterRules[i];
+
+		if((header->shelfID < rule->shelfLow) || (header->shelfID > rule->shelfHigh))
+			continue;
+
+		if((header->dataSize < rule->sizeLow) || (header->dataSize > rule->sizeHigh))
+			continue;
+
+		if(!filterChannels(header, rule->channelMask))
+			continue;
+
+		rule->hits++;
+		filterPassed++;
+		return 1;
+	}
+
+	filterDropped++;
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the filter rules
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayFilterRules(void) {
+
+	unsigned int i;
+
+	xil_printf("\nFilter rules (%d)\n", filterRuleCount);
+
+	for(i = 0; i < filterRuleCount; i++) {
+		xil_printf("%d - shelf %d-%d channels 0x%08X size %d-%d \t(%d hits)\n", i,
+				filterRules[i].shelfLow, filterRules[i].shelfHigh,
+				filterRules[i].channelMask,
+				filterRules[i].sizeLow, filterRules[i].sizeHigh,
+				filterRules[i].hits);
+	}
+
+	xil_printf("Frames passed \t\t- %d\n", filterPassed);
+	xil_printf("Frames dropped \t\t- %d\n", filterDropped);
+}
@@ -0,0 +1,31 @@
+/*
+ * @file filter.h
+ */
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include "common.h"
+
+#define FILTER_MAX_RULES		4
+#define FILTER_ALL_CHANNELS		0xFFFFFFFF
+
+/**
+ * @struct filter_rule_struct
+ * @brief frame filter rule, a frame matches when every predicate is true
+ */
+typedef struct filter_rule_type {
+	unsigned int shelfLow;				//!< lowest shelf ID accepted
+	unsigned int shelfHigh;				//!< highest shelf ID accepted
+	unsigned int channelMask;			//!< channels 0-31 accepted, one bit each
+	unsigned int sizeLow;				//!< smallest dataSize accepted
+	unsigned int sizeHigh;				//!< largest dataSize accepted
+	unsigned int hits;					//!< frames accepted by this rule
+} filter_rule_struct;
+
+void filterInit(void);
+int filterAddRule(filter_rule_struct *);
+int filterFrame(strRtspFrameHeader *);
+void displayFilterRules(void);
+
+#endif /* FILTER_H_ */
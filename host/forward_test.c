@@ -0,0 +1,314 @@
+/*
+ * @file forward_test.c
+ * @brief daisy-chain forwarding against simulated link endpoints
+ *
+ * Two boards are chained the way they are on the bench:
+ *
+ *    upstream --> link --> board A --> link --> board B --> link --> downstream
+ *
+ * Each link is a FIFO of frames standing in for an aurora lane, and each
+ * board makes the same checks and decision as runForwarding() using
+ * rtsp_frame.h.  Built and run on a Linux host with "make -C host test".
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rtsp_frame.h"
+
+#define LINK_DEPTH			32				// frames a link can hold
+#define LINK_FRAME_WORDS	1024			// largest simulated frame in words
+#define TEST_CHANNELS		3
+#define TEST_SAMPLES		16
+
+/**
+ * @struct link_struct
+ * @brief one direction of a simulated aurora lane
+ */
+typedef struct link_type {
+	unsigned int	frame[LINK_DEPTH][LINK_FRAME_WORDS];
+	unsigned int	size[LINK_DEPTH];			//!< frame sizes in bytes
+	unsigned int	head;						//!< next frame to receive
+	unsigned int	count;						//!< frames in flight
+} link_struct;
+
+/**
+ * @struct board_struct
+ * @brief a simulated board in the chain
+ */
+typedef struct board_type {
+	unsigned int	shelfID;
+	link_struct *	rx;							//!< upstream link
+	link_struct *	tx;							//!< downstream link
+	unsigned int	consumed[LINK_DEPTH];		//!< headerIDs of the frames kept
+	unsigned int	consumedCount;
+	unsigned int	forwarded;
+	unsigned int	dropped;
+} board_struct;
+
+static link_struct upstream, middle, downstream;
+
+static int failures;
+
+static void check(int ok, const char *what) {
+
+	printf("%s - %s\n", ok ? "PASS" : "FAIL", what);
+
+	if(!ok)
+		failures++;
+}
+
+static void linkReset(link_struct *link) {
+
+	link->head = 0;
+	link->count = 0;
+}
+
+static int linkSend(link_struct *link, unsigned int *frame, unsigned int size) {
+
+	unsigned int tail = (link->head + link->count) % LINK_DEPTH;
+
+	if((link->count == LINK_DEPTH) || (size > sizeof(link->frame[0])))
+		return -1;
+
+	memcpy(link->frame[tail], frame, size);
+	link->size[tail] = size;
+	link->count++;
+
+	return 0;
+}
+
+static unsigned int linkReceive(link_struct *link, unsigned int *frame) {
+
+	unsigned int size;
+
+	if(link->count == 0)
+		return 0;
+
+	size = link->size[link->head];
+	memcpy(frame, link->frame[link->head], size);
+
+	link->head = (link->head + 1) % LINK_DEPTH;
+	link->count--;
+
+	return size;
+}
+
+/*
+ * build a frame of TEST_CHANNELS channels, headerID carries a sequence
+ * number so the frames can be told apart at the far end
+ */
+static unsigned int buildFrame(unsigned int *frame, unsigned int shelfID, unsigned int sequence) {
+
+	strRtspFrameHeader *header = (strRtspFrameHeader *)((unsigned char *)frame + RTSP_SYNC_SIZE);
+	unsigned int *word = (unsigned int *)(header + 1);
+	strRtspChannelHeader *channel;
+	unsigned int ch, i, size;
+
+	frame[0] = RTSP_SYNC_WORD;
+	header->headerID = sequence;
+	header->shelfID = shelfID;
+	header->dataSize = TEST_CHANNELS * (RTSP_CHANNEL_HEADER_WORDS + TEST_SAMPLES);
+
+	for(ch = 0; ch < TEST_CHANNELS; ch++) {
+		channel = (strRtspChannelHeader *)word;
+		memset(channel, 0, sizeof(*channel));
+		channel->channelNumber = ch;
+		channel->channelSize = (RTSP_CHANNEL_HEADER_WORDS - 1) + TEST_SAMPLES;
+		channel->W = 1;
+		channel->N[0] = TEST_SAMPLES;
+
+		word += RTSP_CHANNEL_HEADER_WORDS;
+		for(i = 0; i < TEST_SAMPLES; i++)
+			*word++ = (sequence << 16) | (ch << 8) | i;
+	}
+
+	size = rtspFrameSize(header);
+	for(; word < frame + (size / 4); word++)
+		*word = 0;
+
+	return size;
+}
+
+/*
+ * one pass of the forwarding loop, receive, check, keep or send on
+ */
+static void boardStep(board_struct *board) {
+
+	static unsigned int frame[LINK_FRAME_WORDS];
+	strRtspFrameHeader *header = (strRtspFrameHeader *)((unsigned char *)frame + RTSP_SYNC_SIZE);
+	unsigned int size;
+
+	while((size = linkReceive(board->rx, frame)) != 0) {
+
+		if(rtspCheckFrame((unsigned char *)frame, size, RTSP_HEADER_ID_ANY) != RTSP_VALID) {
+			board->dropped++;
+			continue;
+		}
+
+		if(forwardDecision(header, board->shelfID) == RTSP_CONSUME) {
+			board->consumed[board->consumedCount++] = header->headerID;
+			continue;
+		}
+
+		if(linkSend(board->tx, frame, size) == 0)
+			board->forwarded++;
+	}
+}
+
+static void chainReset(board_struct *a, board_struct *b, unsigned int shelfA, unsigned int shelfB) {
+
+	linkReset(&upstream);
+	linkReset(&middle);
+	linkReset(&downstream);
+
+	memset(a, 0, sizeof(*a));
+	memset(b, 0, sizeof(*b));
+
+	a->shelfID = shelfA;
+	a->rx = &upstream;
+	a->tx = &middle;
+
+	b->shelfID = shelfB;
+	b->rx = &middle;
+	b->tx = &downstream;
+}
+
+static void testRouting(void) {
+
+	static unsigned int sent[9][LINK_FRAME_WORDS];
+	static unsigned int out[LINK_FRAME_WORDS];
+	unsigned int sizes[9];
+	unsigned int shelves[9] = {1, 2, 3, 2, 1, 3, 3, 1, 2};
+	board_struct a, b;
+	unsigned int i, size, match = 1, order = 1, next = 0;
+
+	chainReset(&a, &b, 1, 2);
+
+	for(i = 0; i < 9; i++) {
+		sizes[i] = buildFrame(sent[i], shelves[i], i);
+		linkSend(&upstream, sent[i], sizes[i]);
+	}
+
+	boardStep(&a);
+	boardStep(&b);
+
+	check((a.consumedCount == 3) && (a.consumed[0] == 0) && (a.consumed[1] == 4) && (a.consumed[2] == 7),
+			"board A keeps the shelf 1 frames in order");
+	check((b.consumedCount == 3) && (b.consumed[0] == 1) && (b.consumed[1] == 3) && (b.consumed[2] == 8),
+			"board B keeps the shelf 2 frames in order");
+	check((a.forwarded == 6) && (b.forwarded == 3) && (a.dropped == 0) && (b.dropped == 0),
+			"everything else is forwarded, nothing dropped");
+
+	/*
+	 * the shelf 3 frames leave the chain untouched and in order
+	 */
+	for(i = 0; i < 3; i++) {
+		size = linkReceive(&downstream, out);
+
+		while((next < 9) && (shelves[next] != 3))
+			next++;
+
+		if((next == 9) || (size != sizes[next]))
+			order = 0;
+		else if(memcmp(out, sent[next], size) != 0)
+			match = 0;
+
+		next++;
+	}
+
+	check(order && (downstream.count == 0), "shelf 3 frames reach the downstream end in order");
+	check(match, "forwarded frames are byte for byte what was sent");
+}
+
+static void testBadFrames(void) {
+
+	static unsigned int frame[LINK_FRAME_WORDS];
+	strRtspFrameHeader *header = (strRtspFrameHeader *)((unsigned char *)frame + RTSP_SYNC_SIZE);
+	strRtspChannelHeader *channel = (strRtspChannelHeader *)(header + 1);
+	board_struct a, b;
+	unsigned int size;
+
+	chainReset(&a, &b, 1, 2);
+
+	size = buildFrame(frame, 2, 0);
+	frame[0] = 0;											// lost sync
+	linkSend(&upstream, frame, size);
+
+	size = buildFrame(frame, 2, 1);
+	header->dataSize = 0x40000000;							// frame size wraps
+	linkSend(&upstream, frame, size);
+
+	size = buildFrame(frame, 2, 2);
+	channel->channelSize = header->dataSize;				// channel runs off the end
+	linkSend(&upstream, frame, size);
+
+	size = buildFrame(frame, 2, 3);
+	linkSend(&upstream, frame, size);
+
+	boardStep(&a);
+	boardStep(&b);
+
+	check((a.dropped == 3) && (a.forwarded == 1), "bad frames are dropped by the first board");
+	check((b.consumedCount == 1) && (b.consumed[0] == 3), "the good frame still arrives");
+
+	check(rtspCheckFrame((unsigned char *)frame, RTSP_MIN_FRAME_SIZE - 1, RTSP_HEADER_ID_ANY) == RTSP_BAD_SIZE,
+			"a buffer smaller than a header is rejected");
+
+	size = buildFrame(frame, 2, 5);
+	check(rtspCheckFrame((unsigned char *)frame, size, 4) == RTSP_BAD_HEADER_ID,
+			"a header ID other than the one expected is rejected");
+}
+
+static void testUnassigned(void) {
+
+	static unsigned int frame[LINK_FRAME_WORDS];
+	board_struct a, b;
+	unsigned int i, size;
+
+	chainReset(&a, &b, RTSP_SHELF_NONE, 2);
+
+	for(i = 0; i < 4; i++) {
+		size = buildFrame(frame, (i & 1) ? RTSP_SHELF_NONE : 2, i);
+		linkSend(&upstream, frame, size);
+	}
+
+	boardStep(&a);
+	boardStep(&b);
+
+	check((a.consumedCount == 0) && (a.forwarded == 4), "a board without a shelf ID forwards everything");
+	check((b.consumedCount == 2) && (downstream.count == 2), "a frame for no shelf is never consumed");
+}
+
+static void testChannelWalk(void) {
+
+	static unsigned int frame[LINK_FRAME_WORDS];
+	strRtspFrameHeader *header = (strRtspFrameHeader *)((unsigned char *)frame + RTSP_SYNC_SIZE);
+	strRtspChannelHeader *channel;
+	unsigned int count = 0, numbers = 1;
+
+	buildFrame(frame, 1, 0);
+
+	for(channel = rtspFirstChannel(header); channel != NULL; channel = rtspNextChannel(header, channel)) {
+		if(channel->channelNumber != count)
+			numbers = 0;
+		count++;
+	}
+
+	check((count == TEST_CHANNELS) && numbers, "every channel is walked once");
+
+	header->dataSize = RTSP_CHANNEL_HEADER_WORDS - 1;
+	check(rtspFirstChannel(header) == NULL, "a frame too small for a channel has none");
+}
+
+int main(void) {
+
+	testRouting();
+	testBadFrames();
+	testUnassigned();
+	testChannelWalk();
+
+	printf("\n%d failed\n", failures);
+
+	return failures ? 1 : 0;
+}
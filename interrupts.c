@@ -13,6 +13,7 @@
 #include "common.h"
 #include "xparameters.h"
 #include "nwl_dma.h"
+#include "dma.h"
 
 /*****************************************************************************/
 /**
@@ -145,7 +146,7 @@ int setupInterruptController(params_struct *pParams) {
  * @note 	none
  *
 ******************************************************************************/
-void nwlDMA_InterruptHandler(void *CallbackRef) {
+HOT_CODE void nwlDMA_InterruptHandler(void *CallbackRef) {
 
 #ifdef __DEBUG
 	xil_printf("\nNWL Interrupt\n");
@@ -170,7 +171,7 @@ void nwlDMA_InterruptHandler(void *CallbackRef) {
  * 		@note 	none
  *
 ******************************************************************************/
-void mbIntHandler(void){
+HOT_CODE void mbIntHandler(void){
 
 	/* disable interrupts */
 	XIntc_Disable(pParams->pInterruptController, XPAR_INTC_0_DEVICE_ID);
@@ -199,10 +200,9 @@ void mbIntHandler(void){
  * @note 	none
  *
 ******************************************************************************/
-void dmaMM2S_InterruptHandler(void *CallbackRef) {
+HOT_CODE void dmaMM2S_InterruptHandler(void *CallbackRef) {
 
 	u32 IrqStatus = 0x00;
-	int TimeOut;
 	XAxiDma *AxiDmaInst = (XAxiDma *)CallbackRef;
 
 #ifdef __DEBUG
@@ -246,25 +246,10 @@ void dmaMM2S_InterruptHandler(void *CallbackRef) {
 		tmpAddr = (unsigned int *)(AxiDmaInst->RegBase+0x4c);val = *(tmpAddr); xil_printf("0x%08X\t0x%08X\n",tmpAddr,val);
 		tmpAddr = (unsigned int *)(AxiDmaInst->RegBase+0x58);val = *(tmpAddr); xil_printf("0x%08X\t0x%08X\n",tmpAddr,val);
 #endif
-		Error = 1;
-
 		/*
-		 * Reset should never fail for transmit channel
+		 * the reset is left to dmaRecover() so it cannot hang the handler
 		 */
-
-		XAxiDma_Reset(AxiDmaInst);
-		TimeOut = RESET_TIMEOUT_COUNTER;
-
-
-		while (TimeOut) {
-			if (XAxiDma_ResetIsDone(AxiDmaInst)) {
-				break;
-			}
-
-			TimeOut -= 1;
-		}
-
-		xil_printf("timeout\n");
+		dmaErrorRaise(XAXIDMA_DMA_TO_DEVICE, IrqStatus);
 		return;
 	}
 
@@ -296,10 +281,9 @@ void dmaMM2S_InterruptHandler(void *CallbackRef) {
  * @note 	none
  *
 ******************************************************************************/
-void dmaS2MM_InterruptHandler(void *CallbackRef) {
+HOT_CODE void dmaS2MM_InterruptHandler(void *CallbackRef) {
 
 	u32 IrqStatus;
-	int TimeOut;
 	XAxiDma *AxiDmaInst = (XAxiDma *)CallbackRef;
 
 #ifdef __DEBUG
@@ -326,13 +310,12 @@ void dmaS2MM_InterruptHandler(void *CallbackRef) {
 	 */
 	if ((IrqStatus & XAXIDMA_IRQ_ERROR_MASK)) {
 
-		xil_printf("\nRX Error (0x%08X)\n",IrqStatus);
-
-
 #ifdef __DEBUG
 		unsigned int *tmpAddr;
 		unsigned int val;
 
+		xil_printf("\nRX Error (0x%08X)\n",IrqStatus);
+
 		tmpAddr = (unsigned int *)(AxiDmaInst->RegBase+0x00);val = *(tmpAddr); xil_printf("\n0x%08X\t0x%08X\n",tmpAddr,val);
 		tmpAddr = (unsigned int *)(AxiDmaInst->RegBase+0x04);val = *(tmpAddr); xil_printf("0x%08X\t0x%08X\n",tmpAddr,val);
 		tmpAddr = (unsigned int *)(AxiDmaInst->RegBase+0x18);val = *(tmpAddr); xil_printf("0x%08X\t0x%08X\n",tmpAddr,val);
@@ -346,20 +329,10 @@ void dmaS2MM_InterruptHandler(void *CallbackRef) {
 
 #endif
 
-		Error = 1;
-
-		/* Reset could fail and hang
-		 * NEED a way to handle this or do not call it??
+		/*
+		 * the reset is left to dmaRecover() so it cannot hang the handler
 		 */
-		XAxiDma_Reset(AxiDmaInst);
-		TimeOut = RESET_TIMEOUT_COUNTER;
-
-		while (TimeOut) {
-			if(XAxiDma_ResetIsDone(AxiDmaInst)) {
-				break;
-			}
-			TimeOut -= 1;
-		}
+		dmaErrorRaise(XAXIDMA_DEVICE_TO_DMA, IrqStatus);
 		return;
 	}
 
@@ -8,6 +8,9 @@
 #include "nwl_dma.h"
 #include "common.h"
 #include "uart.h"
+#include "cache.h"
+
+static nwl_reaper_struct reapers[NWL_CHANNELS];
 
 /*****************************************************************************/
 /**
@@ -237,3 +240,153 @@ void dmaResults(params_struct *pParams) {
 	xil_printf("\n\n>");
 }
 
+
+/*****************************************************************************/
+/**
+ * @brief start reaping a channel's status queue
+ * This function picks up the status queue the channel has been given from
+ * its registers.  The first element to retire is the one after STA_Q_LIMIT,
+ * the oldest the engine may have written.
+ *
+ * @param	p is a pointer to the parameters structure
+ * @param	channel selects the DMA channel
+ *
+ * @return	success/failure
+ *
+ * @note 	the queue has to be on the AXI side, one in host memory cannot be
+ * 			read from here
+ *
+******************************************************************************/
+int nwlReaperInit(params_struct *p, unsigned int channel) {
+
+	volatile dma_reg_struct *regs = p->pDmaChannelRegisters[channel];
+	nwl_reaper_struct *r = &reapers[channel];
+	unsigned int ptr = regs->STA_Q_PTR_LO;
+	unsigned int size = regs->STA_Q_SIZE;
+
+	r->ring = NULL;
+
+	if(!(ptr & 0x01) || (size == 0))					// bit 0 - queue is on the AXI side
+		return XST_FAILURE;
+
+	r->ring = (struct sgStatusElement *)(ptr & ~0x03);
+	r->size = size;
+	r->next = (regs->STA_Q_LIMIT + 1) % size;
+	r->batches = 0;
+	r->retired = 0;
+	r->maxBatch = 0;
+	r->notCompleted = 0;
+	r->sourceErrors = 0;
+	r->destinationErrors = 0;
+	r->internalErrors = 0;
+
+	if(channel == 0)
+		p->statusSglAddress = r->ring;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief retire every finished descriptor on a channel
+ * This function reads STA_Q_NEXT once and walks the status queue from the
+ * last element retired up to it, gathering the error bits as it goes.  The
+ * elements are given back to the engine with a single STA_Q_LIMIT write for
+ * the whole batch rather than one per descriptor.
+ *
+ * @param	p is a pointer to the parameters structure
+ * @param	channel selects the DMA channel
+ * @param	errors is a pointer to where the NWL_STA_*_ERROR bits seen in this
+ * 			batch are returned, may be NULL
+ *
+ * @return	number of descriptors retired
+ *
+ * @note 	does nothing until nwlReaperInit() has found the queue
+ *
+******************************************************************************/
+HOT_CODE int nwlReap(params_struct *p, unsigned int channel, unsigned int *errors) {
+
+	volatile dma_reg_struct *regs = p->pDmaChannelRegisters[channel];
+	nwl_reaper_struct *r = &reapers[channel];
+	struct sgStatusElement e;
+	unsigned int head, count = 0, seen = 0;
+
+	if(errors != NULL)
+		*errors = 0;
+
+	if(r->ring == NULL)
+		return 0;
+
+	head = regs->STA_Q_NEXT;
+	if((head >= r->size) || (head == r->next))
+		return 0;
+
+	/*
+	 * the engine wrote the queue behind the cache
+	 */
+	cacheInvalidate(r->ring, r->size * sizeof(struct sgStatusElement));
+
+	while(r->next != head) {
+		e = r->ring[r->next];
+
+		if(!e.completed)
+			r->notCompleted++;
+
+		if(e.sourceError) {
+			r->sourceErrors++;
+			seen |= NWL_STA_SOURCE_ERROR;
+		}
+
+		if(e.destinationError) {
+			r->destinationErrors++;
+			seen |= NWL_STA_DESTINATION_ERROR;
+		}
+
+		if(e.internalError) {
+			r->internalErrors++;
+			seen |= NWL_STA_INTERNAL_ERROR;
+		}
+
+		r->next = (r->next + 1) % r->size;
+		count++;
+	}
+
+	regs->STA_Q_LIMIT = (r->next + r->size - 1) % r->size;	// one element short of the next to retire
+
+	r->batches++;
+	r->retired += count;
+	if(count > r->maxBatch)
+		r->maxBatch = count;
+
+	if(errors != NULL)
+		*errors = seen;
+
+	return count;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the status queue counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayNwlReaper(void) {
+
+	int i;
+	nwl_reaper_struct *r;
+
+	xil_printf("\nNWL\tQueue\t\tNext\tBatches\tRetired\tLargest\tIncomplete\tSrc/Dst/Int errors\n");
+
+	for(i = 0; i < NWL_CHANNELS; i++) {
+		r = &reapers[i];
+		if(r->ring == NULL)
+			continue;
+
+		xil_printf("%d\t0x%08X\t%d/%d\t%d\t%d\t%d\t%d\t\t%d/%d/%d\n", i, (u32)r->ring,
+				r->next, r->size, r->batches, r->retired, r->maxBatch, r->notCompleted,
+				r->sourceErrors, r->destinationErrors, r->internalErrors);
+	}
+}
@@ -10,8 +10,33 @@
 
 #include "common.h"
 
+#define NWL_CHANNELS			3
+
+#define NWL_STA_SOURCE_ERROR		0x01		// error bits gathered by nwlReap()
+#define NWL_STA_DESTINATION_ERROR	0x02
+#define NWL_STA_INTERNAL_ERROR		0x04
+
+/**
+ * @struct nwl_reaper_struct
+ * @brief status queue position and completion counters for one channel
+ */
+typedef struct nwl_reaper_type {
+	struct sgStatusElement *	ring;				//!< status queue, NULL if not reaping
+	unsigned int				size;				//!< elements in the queue
+	unsigned int				next;				//!< next element to retire
+	unsigned int				batches;			//!< passes that retired something
+	unsigned int				retired;			//!< descriptors retired
+	unsigned int				maxBatch;			//!< most retired in one pass
+	unsigned int				notCompleted;		//!< elements retired without the completed bit
+	unsigned int				sourceErrors;
+	unsigned int				destinationErrors;
+	unsigned int				internalErrors;
+} nwl_reaper_struct;
 
 int init_DMA(params_struct *, unsigned int);
+int nwlReaperInit(params_struct *, unsigned int);
+int nwlReap(params_struct *, unsigned int, unsigned int *);
+void displayNwlReaper(void);
 
 void resetAxiInterrupt(unsigned int);
 void dmaResults(params_struct *);
@@ -0,0 +1,541 @@
+/*
+ * @file pack.c
+ * @brief packing of 32 bit samples to 16 or 24 bits for the aurora
+ */
+
+#include "pack.h"
+#include "rtsp.h"
+#include "cache.h"
+
+static pack_struct pack;
+
+/*****************************************************************************/
+/**
+ * @brief set up sample packing
+ * This function turns packing off and clears the channel shifts
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+void packInit(void) {
+
+	int i;
+
+	pack.width = PACK_OFF;
+
+	for(i = 0; i < PACK_MAX_CHANNELS; i++)
+		pack.shift[i] = 0;
+
+	pack.framesPacked = 0;
+	pack.framesUnpacked = 0;
+	pack.channelsSkipped = 0;
+	pack.samplesClipped = 0;
+	pack.wordsSaved = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief set the packed width and a channel shift
+ *
+ * @param	width holds PACK_OFF, PACK_16 or PACK_24
+ * @param	channel holds the channel number or PACK_ALL_CHANNELS
+ * @param	shift holds the right shift applied before narrowing
+ *
+ * @return	success/failure
+ *
+ * @note 	none
+ *
+******************************************************************************/
+int packSet(unsigned int width, unsigned int channel, unsigned int shift) {
+
+	int i;
+
+	if((width != PACK_OFF) && (width != PACK_16) && (width != PACK_24))
+		return XST_FAILURE;
+
+	if(((channel >= PACK_MAX_CHANNELS) && (channel != PACK_ALL_CHANNELS)) || (shift > PACK_MAX_SHIFT))
+		return XST_FAILURE;
+
+	pack.width = width;
+
+	for(i = 0; i < PACK_MAX_CHANNELS; i++) {
+		if((channel == PACK_ALL_CHANNELS) || (channel == i))
+			pack.shift[i] = shift;
+	}
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief get the packed width
+ *
+ * @return	PACK_OFF, PACK_16 or PACK_24
+ *
+ * @note 	none
+ *
+******************************************************************************/
+unsigned int packWidth(void) {
+
+	return pack.width;
+}
+
+/*****************************************************************************/
+/**
+ * @brief get a channel shift
+ *
+ * @param	channel holds the channel number
+ *
+ * @return	right shift applied before narrowing, 0 past PACK_MAX_CHANNELS
+ *
+ * @note 	none
+ *
+******************************************************************************/
+unsigned int packShift(unsigned int channel) {
+
+	return (channel < PACK_MAX_CHANNELS) ? pack.shift[channel] : 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief narrow one sample
+ * This function shifts a signed sample right and saturates it to the packed
+ * width
+ *
+ * @param	sample holds the 32 bit sample
+ * @param	shift holds the right shift
+ * @param	limit holds 2^(width-1)
+ *
+ * @return	sample in the low width bits, upper bits clear
+ *
+ * @note 	none
+ *
+******************************************************************************/
+static inline unsigned int packSample(unsigned int sample, unsigned int shift, int limit) {
+
+	int s = (int)sample >> shift;
+
+	if(s >= limit) {
+		s = limit - 1;
+		pack.samplesClipped++;
+	} else if(s < -limit) {
+		s = -limit;
+		pack.samplesClipped++;
+	}
+
+	return (unsigned int)s & (((unsigned int)limit << 1) - 1);
+}
+
+/*****************************************************************************/
+/**
+ * @brief sign extend a packed sample and undo its shift
+ *
+ * @param	bits holds the packed sample in its low width bits
+ * @param	unused holds 32 - width
+ * @param	shift holds the left shift
+ *
+ * @return	32 bit sample
+ *
+ * @note 	none
+ *
+******************************************************************************/
+static inline unsigned int unpackSample(unsigned int bits, unsigned int unused, unsigned int shift) {
+
+	return (unsigned int)((int)(bits << unused) >> unused) << shift;
+}
+
+/*****************************************************************************/
+/**
+ * @brief pack samples two to a word
+ *
+ * @param	in is a pointer to the 32 bit samples
+ * @param	out is a pointer to the packed words, may be in
+ * @param	n holds the number of samples
+ * @param	shift holds the right shift
+ *
+ * @return	words written
+ *
+ * @note 	the first sample of a pair goes in the low half
+ *
+******************************************************************************/
+HOT_CODE static unsigned int pack16(unsigned int *in, unsigned int *out, unsigned int n, unsigned int shift) {
+
+	unsigned int *start = out;
+	unsigned int a, b;
+	unsigned int i;
+
+	for(i = 0; (i + 1) < n; i += 2) {
+		a = packSample(in[i], shift, 0x8000);
+		b = packSample(in[i + 1], shift, 0x8000);
+		*out++ = a | (b << 16);
+	}
+
+	if(i < n)
+		*out++ = packSample(in[i], shift, 0x8000);
+
+	return out - start;
+}
+
+/*****************************************************************************/
+/**
+ * @brief pack samples four to three words
+ *
+ *    word 0 - b[7:0]   a[23:0]
+ *    word 1 - c[15:0]  b[23:8]
+ *    word 2 - d[23:0]  c[23:16]
+ *
+ * @param	in is a pointer to the 32 bit samples
+ * @param	out is a pointer to the packed words, may be in
+ * @param	n holds the number of samples
+ * @param	shift holds the right shift
+ *
+ * @return	words written
+ *
+ * @note 	a short group at the end uses only the words it needs
+ *
+******************************************************************************/
+HOT_CODE static unsigned int pack24(unsigned int *in, unsigned int *out, unsigned int n, unsigned int shift) {
+
+	unsigned int *start = out;
+	unsigned int a, b, c, d;
+	unsigned int i;
+
+	for(i = 0; (i + 3) < n; i += 4) {
+		a = packSample(in[i], shift, 0x800000);
+		b = packSample(in[i + 1], shift, 0x800000);
+		c = packSample(in[i + 2], shift, 0x800000);
+		d = packSample(in[i + 3], shift, 0x800000);
+
+		out[0] = a | (b << 24);
+		out[1] = (b >> 8) | (c << 16);
+		out[2] = (c >> 16) | (d << 8);
+		out += 3;
+	}
+
+	if(i < n) {
+		a = packSample(in[i], shift, 0x800000);
+		b = ((i + 1) < n) ? packSample(in[i + 1], shift, 0x800000) : 0;
+		c = ((i + 2) < n) ? packSample(in[i + 2], shift, 0x800000) : 0;
+
+		*out++ = a | (b << 24);
+		if((i + 1) < n)
+			*out++ = (b >> 8) | (c << 16);
+		if((i + 2) < n)
+			*out++ = c >> 16;
+	}
+
+	return out - start;
+}
+
+/*****************************************************************************/
+/**
+ * @brief unpack samples stored two to a word
+ *
+ * @param	in is a pointer to the packed words
+ * @param	out is a pointer to the 32 bit samples
+ * @param	n holds the number of samples
+ * @param	shift holds the left shift
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE static void unpack16(unsigned int *in, unsigned int *out, unsigned int n, unsigned int shift) {
+
+	unsigned int w;
+	unsigned int i;
+
+	for(i = 0; (i + 1) < n; i += 2) {
+		w = *in++;
+		out[i] = unpackSample(w, 16, shift);
+		out[i + 1] = unpackSample(w >> 16, 16, shift);
+	}
+
+	if(i < n)
+		out[i] = unpackSample(*in, 16, shift);
+}
+
+/*****************************************************************************/
+/**
+ * @brief unpack samples stored four to three words
+ *
+ * @param	in is a pointer to the packed words
+ * @param	out is a pointer to the 32 bit samples
+ * @param	n holds the number of samples
+ * @param	shift holds the left shift
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE static void unpack24(unsigned int *in, unsigned int *out, unsigned int n, unsigned int shift) {
+
+	unsigned int w0, w1, w2;
+	unsigned int i;
+
+	for(i = 0; (i + 3) < n; i += 4) {
+		w0 = in[0];
+		w1 = in[1];
+		w2 = in[2];
+		in += 3;
+
+		out[i] = unpackSample(w0, 8, shift);
+		out[i + 1] = unpackSample((w0 >> 24) | (w1 << 8), 8, shift);
+		out[i + 2] = unpackSample((w1 >> 16) | (w2 << 16), 8, shift);
+		out[i + 3] = unpackSample(w2 >> 8, 8, shift);
+	}
+
+	if(i < n) {
+		w0 = in[0];
+		w1 = ((i + 1) < n) ? in[1] : 0;
+		w2 = ((i + 2) < n) ? in[2] : 0;
+
+		out[i] = unpackSample(w0, 8, shift);
+		if((i + 1) < n)
+			out[i + 1] = unpackSample((w0 >> 24) | (w1 << 8), 8, shift);
+		if((i + 2) < n)
+			out[i + 2] = unpackSample((w1 >> 16) | (w2 << 16), 8, shift);
+	}
+}
+
+/*****************************************************************************/
+/**
+ * @brief number of samples in a channel
+ *
+ * @param	channel is a pointer to the channel header
+ * @param	ranges holds the number of ranges
+ *
+ * @return	sum of N[], 0xFFFFFFFF if there are too many ranges
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE static unsigned int packSamples(strRtspChannelHeader *channel, unsigned int ranges) {
+
+	unsigned int samples = 0;
+	unsigned int i;
+
+	if(ranges > RTSP_MAX_RANGES)
+		return 0xFFFFFFFF;
+
+	for(i = 0; i < ranges; i++)
+		samples += channel->N[i];
+
+	return samples;
+}
+
+/*****************************************************************************/
+/**
+ * @brief pack one channel
+ * This function narrows the samples of a channel and writes the channel,
+ * header first, at dst.  dst is never past src so the channel can be moved
+ * down the frame as it is packed.
+ *
+ * @param	src is a pointer to the channel header
+ * @param	dst is a pointer to where the packed channel goes
+ *
+ * @return	words written
+ *
+ * @note 	a channel that is already packed or whose N[] does not add up to
+ * 			its channelSize is copied as it is
+ *
+******************************************************************************/
+HOT_CODE static unsigned int packChannel(strRtspChannelHeader *src, unsigned int *dst) {
+
+	unsigned int *in = (unsigned int *)src;
+	unsigned int words = src->channelSize + 1;
+	unsigned int W = src->W;
+	unsigned int samples, shift, n, i;
+
+	samples = packSamples(src, W);
+	shift = (src->channelNumber < PACK_MAX_CHANNELS) ? pack.shift[src->channelNumber] : 0;
+
+	if(samples != (words - RTSP_CHANNEL_HEADER_WORDS)) {
+		pack.channelsSkipped++;
+
+		if(dst != in) {
+			for(i = 0; i < words; i++)
+				dst[i] = in[i];
+		}
+
+		return words;
+	}
+
+	for(i = 0; i < RTSP_CHANNEL_HEADER_WORDS; i++)
+		dst[i] = in[i];
+
+	in += RTSP_CHANNEL_HEADER_WORDS;
+
+	if(pack.width == PACK_16)
+		n = pack16(in, dst + RTSP_CHANNEL_HEADER_WORDS, samples, shift);
+	else
+		n = pack24(in, dst + RTSP_CHANNEL_HEADER_WORDS, samples, shift);
+
+	((strRtspChannelHeader *)dst)->W = W | (pack.width << PACK_W_WIDTH_POS) | (shift << PACK_W_SHIFT_POS);
+	((strRtspChannelHeader *)dst)->channelSize = (RTSP_CHANNEL_HEADER_WORDS - 1) + n;
+
+	return RTSP_CHANNEL_HEADER_WORDS + n;
+}
+
+/*****************************************************************************/
+/**
+ * @brief unpack one channel
+ *
+ * @param	src is a pointer to the channel header
+ * @param	dst is a pointer to where the 32 bit channel goes
+ * @param	room holds the words free at dst
+ *
+ * @return	words written, RTSP_EXPAND_FULL if the channel would not fit
+ *
+ * @note 	a channel that is not packed, or does not add up, is copied as it is
+ *
+******************************************************************************/
+HOT_CODE static unsigned int unpackChannel(strRtspChannelHeader *src, unsigned int *dst, unsigned int room) {
+
+	unsigned int *in = (unsigned int *)src;
+	unsigned int words = src->channelSize + 1;
+	unsigned int ranges = src->W & PACK_W_RANGES;
+	unsigned int width = src->W >> PACK_W_WIDTH_POS;
+	unsigned int shift = (src->W & PACK_W_SHIFT_MASK) >> PACK_W_SHIFT_POS;
+	unsigned int samples, i;
+
+	samples = packSamples(src, ranges);
+
+	if(((width != PACK_16) && (width != PACK_24)) ||
+			(((samples * width) + 31) / 32 != (words - RTSP_CHANNEL_HEADER_WORDS))) {
+		if(words > room)
+			return RTSP_EXPAND_FULL;
+
+		for(i = 0; i < words; i++)
+			dst[i] = in[i];
+
+		return words;
+	}
+
+	if((room < RTSP_CHANNEL_HEADER_WORDS) || (samples > (room - RTSP_CHANNEL_HEADER_WORDS)))
+		return RTSP_EXPAND_FULL;
+
+	for(i = 0; i < RTSP_CHANNEL_HEADER_WORDS; i++)
+		dst[i] = in[i];
+
+	in += RTSP_CHANNEL_HEADER_WORDS;
+
+	if(width == PACK_16)
+		unpack16(in, dst + RTSP_CHANNEL_HEADER_WORDS, samples, shift);
+	else
+		unpack24(in, dst + RTSP_CHANNEL_HEADER_WORDS, samples, shift);
+
+	((strRtspChannelHeader *)dst)->W = ranges;
+	((strRtspChannelHeader *)dst)->channelSize = (RTSP_CHANNEL_HEADER_WORDS - 1) + samples;
+
+	return RTSP_CHANNEL_HEADER_WORDS + samples;
+}
+
+/*****************************************************************************/
+/**
+ * @brief pack a frame in place
+ * This function packs every channel of a frame and closes up the gaps, so the
+ * frame stays contiguous and can be sent from where it is.  dataSize,
+ * channelSize and W are rewritten to match.
+ *
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	size holds the frame size in bytes
+ *
+ * @return	new frame size in bytes
+ *
+ * @note 	a changed frame is marked dirty for the next cacheCommit()
+ *
+******************************************************************************/
+HOT_CODE unsigned int packFrame(u8 *frame, unsigned int size) {
+
+	unsigned int saved;
+
+	if(pack.width == PACK_OFF)
+		return size;
+
+	saved = rtspShrinkFrame(frame, packChannel);
+
+	if(saved == 0)
+		return size;
+
+	pack.framesPacked++;
+	pack.wordsSaved += saved;
+
+	size = rtspFrameSize((strRtspFrameHeader *)(frame + RTSP_SYNC_SIZE));
+
+	cacheDirty(frame, size);
+
+	return size;
+}
+
+/*****************************************************************************/
+/**
+ * @brief unpack a received frame
+ * This function expands the packed channels of a frame back to 32 bit
+ * samples in a second buffer.  Samples come back with their low shift bits
+ * clear.
+ *
+ * @param	src is a pointer to the start of the received frame (sync word)
+ * @param	dst is a pointer to the buffer for the unpacked frame
+ * @param	dstSize holds the bytes in dst
+ *
+ * @return	size of the unpacked frame in bytes, 0 if nothing was packed or
+ * 			the unpacked frame would not fit in dst
+ *
+ * @note 	when 0 is returned dst does not hold a frame, src is unchanged
+ *
+******************************************************************************/
+HOT_CODE unsigned int unpackFrame(u8 *src, u8 *dst, unsigned int dstSize) {
+
+	strRtspFrameHeader *header = (strRtspFrameHeader *)(src + RTSP_SYNC_SIZE);
+	strRtspChannelHeader *channel;
+	unsigned int size;
+
+	for(channel = rtspFirstChannel(header); channel != NULL; channel = rtspNextChannel(header, channel)) {
+		if(channel->W & PACK_W_WIDTH_MASK)
+			break;
+	}
+
+	if(channel == NULL)
+		return 0;
+
+	size = rtspExpandFrame(src, dst, dstSize, unpackChannel);
+	if(size)
+		pack.framesUnpacked++;
+
+	return size;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the packing settings and counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayPack(void) {
+
+	int i;
+
+	if(pack.width == PACK_OFF)
+		xil_printf("\nPacking off\n");
+	else {
+		xil_printf("\nWidth \t\t\t- %d bits\n", pack.width);
+		xil_printf("Shifts \t\t\t-");
+		for(i = 0; i < PACK_MAX_CHANNELS; i++)
+			xil_printf(" %d", pack.shift[i]);
+		xil_printf("\n");
+	}
+
+	xil_printf("Frames packed \t\t- %d\n", pack.framesPacked);
+	xil_printf("Frames unpacked \t- %d\n", pack.framesUnpacked);
+	xil_printf("Channels skipped \t- %d\n", pack.channelsSkipped);
+	xil_printf("Samples clipped \t- %d\n", pack.samplesClipped);
+	xil_printf("Words saved \t\t- %d\n", pack.wordsSaved);
+}
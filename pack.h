@@ -0,0 +1,49 @@
+/*
+ * @file pack.h
+ */
+
+#ifndef PACK_H_
+#define PACK_H_
+
+#include "common.h"
+
+#define PACK_OFF			0			// samples go out as 32 bit words
+#define PACK_16				16
+#define PACK_24				24
+
+#define PACK_MAX_CHANNELS	32			// channels with their own shift
+#define PACK_ALL_CHANNELS	0xFF		// apply a shift to every channel
+#define PACK_MAX_SHIFT		16
+
+/*
+ * a packed channel is marked in the upper bits of W, which only needs 0-8
+ */
+#define PACK_W_RANGES		0x000000FF	// number of ranges
+#define PACK_W_SHIFT_POS	16			// sample shift
+#define PACK_W_SHIFT_MASK	0x001F0000
+#define PACK_W_WIDTH_POS	24			// sample width, 0 - not packed
+#define PACK_W_WIDTH_MASK	0xFF000000
+
+/**
+ * @struct pack_struct
+ * @brief sample packing settings and counters
+ */
+typedef struct pack_type {
+	unsigned int	width;						//!< PACK_OFF/16/24
+	unsigned int	shift[PACK_MAX_CHANNELS];	//!< right shift before narrowing, by channel number
+	unsigned int	framesPacked;				//!< frames made smaller
+	unsigned int	framesUnpacked;				//!< frames expanded on receive
+	unsigned int	channelsSkipped;			//!< channels left as 32 bit
+	unsigned int	samplesClipped;				//!< samples that did not fit the width
+	unsigned int	wordsSaved;					//!< words taken off the aurora
+} pack_struct;
+
+void packInit(void);
+int packSet(unsigned int, unsigned int, unsigned int);
+unsigned int packWidth(void);
+unsigned int packShift(unsigned int);
+unsigned int packFrame(u8 *, unsigned int);
+unsigned int unpackFrame(u8 *, u8 *, unsigned int);
+void displayPack(void);
+
+#endif /* PACK_H_ */
@@ -0,0 +1,229 @@
+/*
+ * @file pool.c
+ * @brief fixed size DDR frame buffer pools
+ */
+
+#include "pool.h"
+
+static pool_struct pools[POOL_COUNT];
+
+/*****************************************************************************/
+/**
+ * @brief carve a DDR region into a pool
+ * This function splits the region into as many buffers of bufferSize as fit
+ * and puts them all on the free list
+ *
+ * @param	id holds the pool number
+ * @param	name holds the name used by displayPools()
+ * @param	base holds the start of the region
+ * @param	regionSize holds the bytes in the region
+ * @param	bufferSize holds the bytes per buffer
+ *
+ * @return	success/failure
+ *
+ * @note 	base and bufferSize are rounded up to FRAME_ALIGN, the count is
+ * 			cut to POOL_MAX_BUFFERS
+ *
+******************************************************************************/
+int poolInit(int id, const char *name, u32 base, unsigned int regionSize, unsigned int bufferSize) {
+
+	pool_struct *pool = &pools[id];
+	u32 aligned;
+	unsigned int count;
+
+	aligned = (base + FRAME_ALIGN - 1) & ~(FRAME_ALIGN - 1);
+	bufferSize = (bufferSize + FRAME_ALIGN - 1) & ~(FRAME_ALIGN - 1);
+
+	if((bufferSize == 0) || (regionSize < (aligned - base) + bufferSize))
+		return XST_FAILURE;
+
+	count = (regionSize - (aligned - base)) / bufferSize;
+	if(count > POOL_MAX_BUFFERS)
+		count = POOL_MAX_BUFFERS;
+
+	pool->name = name;
+	pool->base = (u8 *)aligned;
+	pool->bufferSize = bufferSize;
+	pool->count = count;
+	pool->lowWater = count;
+	pool->allocs = 0;
+	pool->frees = 0;
+	pool->empty = 0;
+	pool->badFree = 0;
+
+	poolReset(id);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief give every buffer back to a pool
+ *
+ * @param	id holds the pool number
+ *
+ * @return	none
+ *
+ * @note 	the counters are kept, buffer 0 comes off first
+ *
+******************************************************************************/
+void poolReset(int id) {
+
+	pool_struct *pool = &pools[id];
+	unsigned int i;
+
+	for(i = 0; i < pool->count; i++) {
+		pool->next[i] = (i + 1 < pool->count) ? i + 1 : POOL_END;
+		pool->busy[i] = 0;
+	}
+
+	pool->freeHead = pool->count ? 0 : POOL_END;
+	pool->freeCount = pool->count;
+}
+
+/*****************************************************************************/
+/**
+ * @brief take a buffer from a pool
+ *
+ * @param	id holds the pool number
+ *
+ * @return	pointer to the buffer, NULL if none are free
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE u8 *poolAlloc(int id) {
+
+	pool_struct *pool = &pools[id];
+	unsigned int n;
+
+	if(pool->freeHead == POOL_END) {
+		pool->empty++;
+		return NULL;
+	}
+
+	n = pool->freeHead;
+	pool->freeHead = pool->next[n];
+	pool->busy[n] = 1;
+	pool->freeCount--;
+	pool->allocs++;
+
+	if(pool->freeCount < pool->lowWater)
+		pool->lowWater = pool->freeCount;
+
+	return pool->base + (n * pool->bufferSize);
+}
+
+/*****************************************************************************/
+/**
+ * @brief give a buffer back to a pool
+ *
+ * @param	id holds the pool number
+ * @param	buffer is a pointer anywhere inside the buffer
+ *
+ * @return	success/failure
+ *
+ * @note 	a buffer that is not allocated from this pool is counted and left
+ * 			alone
+ *
+******************************************************************************/
+HOT_CODE int poolFree(int id, u8 *buffer) {
+
+	pool_struct *pool = &pools[id];
+	int n;
+
+	n = poolIndex(id, buffer);
+	if((n < 0) || !pool->busy[n]) {
+		pool->badFree++;
+		return XST_FAILURE;
+	}
+
+	pool->busy[n] = 0;
+	pool->next[n] = pool->freeHead;
+	pool->freeHead = n;
+	pool->freeCount++;
+	pool->frees++;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief find the buffer holding an address
+ *
+ * @param	id holds the pool number
+ * @param	buffer is a pointer anywhere inside the buffer
+ *
+ * @return	buffer number, -1 if the address is outside the pool
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE int poolIndex(int id, u8 *buffer) {
+
+	pool_struct *pool = &pools[id];
+
+	if((buffer < pool->base) || (buffer >= pool->base + (pool->count * pool->bufferSize)))
+		return -1;
+
+	return (buffer - pool->base) / pool->bufferSize;
+}
+
+/*****************************************************************************/
+/**
+ * @brief number of free buffers in a pool
+ *
+ * @param	id holds the pool number
+ *
+ * @return	buffers on the free list
+ *
+ * @note 	none
+ *
+******************************************************************************/
+unsigned int poolAvailable(int id) {
+
+	return pools[id].freeCount;
+}
+
+/*****************************************************************************/
+/**
+ * @brief size of the buffers in a pool
+ *
+ * @param	id holds the pool number
+ *
+ * @return	bytes per buffer
+ *
+ * @note 	none
+ *
+******************************************************************************/
+unsigned int poolBufferSize(int id) {
+
+	return pools[id].bufferSize;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the pools
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayPools(void) {
+
+	int i;
+	pool_struct *pool;
+
+	xil_printf("\nPool\t\tBase\t\tSize\t\tFree\tLow\tAllocs\tFrees\tEmpty\tBad\n");
+
+	for(i = 0; i < POOL_COUNT; i++) {
+		pool = &pools[i];
+		if(pool->name == NULL)
+			continue;
+
+		xil_printf("%s\t\t0x%08X\t0x%08X\t%d/%d\t%d\t%d\t%d\t%d\t%d\n", pool->name,
+				(u32)pool->base, pool->bufferSize, pool->freeCount, pool->count, pool->lowWater,
+				pool->allocs, pool->frees, pool->empty, pool->badFree);
+	}
+}
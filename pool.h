@@ -0,0 +1,52 @@
+/*
+ * @file pool.h
+ */
+
+#ifndef POOL_H_
+#define POOL_H_
+
+#include "common.h"
+
+#define POOL_HOST			0			// host frames and NWL loopback data
+#define POOL_DMA			1			// AXI DMA test and bounce buffers
+#define POOL_WORK			2			// unpacked and decompressed frames
+#define POOL_FORWARD		3			// forwarding receive slots
+#define POOL_COUNT			4
+
+#define POOL_MAX_BUFFERS	64
+#define POOL_END			0xFF		// end of a free list
+
+/**
+ * @struct pool_struct
+ * @brief fixed size DDR buffers
+ *
+ * the free list is kept here rather than in the free buffers themselves so a
+ * buffer the CPU has not touched never has a dirty line that could be
+ * written back over DMA data
+ */
+typedef struct pool_type {
+	const char *	name;
+	u8 *			base;								//!< first buffer
+	unsigned int	bufferSize;							//!< bytes per buffer, a multiple of FRAME_ALIGN
+	unsigned int	count;								//!< buffers in the pool
+	u8				next[POOL_MAX_BUFFERS];				//!< free list links
+	u8				busy[POOL_MAX_BUFFERS];				//!< 1-buffer is allocated
+	unsigned int	freeHead;							//!< first free buffer, POOL_END if none
+	unsigned int	freeCount;							//!< buffers on the free list
+	unsigned int	lowWater;							//!< fewest free buffers seen
+	unsigned int	allocs;								//!< buffers handed out
+	unsigned int	frees;								//!< buffers given back
+	unsigned int	empty;								//!< allocs with nothing free
+	unsigned int	badFree;							//!< frees of a free or foreign buffer
+} pool_struct;
+
+int poolInit(int, const char *, u32, unsigned int, unsigned int);
+void poolReset(int);
+u8 *poolAlloc(int);
+int poolFree(int, u8 *);
+int poolIndex(int, u8 *);
+unsigned int poolAvailable(int);
+unsigned int poolBufferSize(int);
+void displayPools(void);
+
+#endif /* POOL_H_ */
@@ -0,0 +1,226 @@
+/*
+ * @file reduce.c
+ * @brief per range decimation and averaging of RTSP channels
+ */
+
+#include "reduce.h"
+#include "rtsp.h"
+#include "cache.h"
+
+static reduce_struct reduce;
+
+/*****************************************************************************/
+/**
+ * @brief set up range reduction
+ * This function turns reduction off and sets every factor to 1
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+void reduceInit(void) {
+
+	int i;
+
+	reduce.mode = REDUCE_OFF;
+
+	for(i = 0; i < REDUCE_RANGES; i++)
+		reduce.shift[i] = 0;
+
+	reduce.framesReduced = 0;
+	reduce.channelsReduced = 0;
+	reduce.channelsSkipped = 0;
+	reduce.wordsSaved = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief set the reduction mode and a range factor
+ *
+ * @param	mode holds REDUCE_OFF, REDUCE_DECIMATE or REDUCE_AVERAGE
+ * @param	range holds the range index (0-7) or REDUCE_ALL_RANGES
+ * @param	factor holds the number of samples folded into one (1, 2, 4 .. 256)
+ *
+ * @return	success/failure
+ *
+ * @note 	a factor that is not a power of 2 is refused
+ *
+******************************************************************************/
+int reduceSet(unsigned int mode, unsigned int range, unsigned int factor) {
+
+	unsigned int shift;
+	int i;
+
+	if((mode > REDUCE_AVERAGE) || ((range >= REDUCE_RANGES) && (range != REDUCE_ALL_RANGES)))
+		return XST_FAILURE;
+
+	for(shift = 0; shift <= REDUCE_MAX_SHIFT; shift++) {
+		if(factor == (1u << shift))
+			break;
+	}
+
+	if(shift > REDUCE_MAX_SHIFT)
+		return XST_FAILURE;
+
+	reduce.mode = mode;
+
+	for(i = 0; i < REDUCE_RANGES; i++) {
+		if((range == REDUCE_ALL_RANGES) || (range == i))
+			reduce.shift[i] = shift;
+	}
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief reduce one channel
+ * This function folds the samples of each range by its factor and writes the
+ * channel, header first, at dst.  dst is never past src so the channel can be
+ * moved down the frame as it is reduced.  Leftover samples at the end of a
+ * range that do not fill a group are dropped.
+ *
+ * @param	src is a pointer to the channel header
+ * @param	dst is a pointer to where the reduced channel goes
+ *
+ * @return	words written
+ *
+ * @note 	samples are taken as signed 32 bit.  a channel whose N[] does not
+ * 			add up to its channelSize is copied as it is.
+ *
+******************************************************************************/
+HOT_CODE static unsigned int reduceChannel(strRtspChannelHeader *src, unsigned int *dst) {
+
+	unsigned int *in = (unsigned int *)src;
+	unsigned int *out = dst;
+	unsigned int words = src->channelSize + 1;
+	unsigned int W = src->W;
+	unsigned int N[REDUCE_RANGES];
+	unsigned int samples = 0;
+	unsigned int i, j, k, n, shift, total;
+	s64 sum;
+
+	if(W <= REDUCE_RANGES) {
+		for(i = 0; i < W; i++) {
+			N[i] = src->N[i];
+			samples += N[i];
+		}
+	}
+
+	if((W > REDUCE_RANGES) || (samples != (words - RTSP_CHANNEL_HEADER_WORDS))) {
+		reduce.channelsSkipped++;
+
+		if(out != in) {
+			for(i = 0; i < words; i++)
+				out[i] = in[i];
+		}
+
+		return words;
+	}
+
+	/*
+	 * header first, N[] is fixed up at the end
+	 */
+	for(i = 0; i < RTSP_CHANNEL_HEADER_WORDS; i++)
+		out[i] = in[i];
+
+	in += RTSP_CHANNEL_HEADER_WORDS;
+	out += RTSP_CHANNEL_HEADER_WORDS;
+	total = 0;
+
+	for(i = 0; i < W; i++) {
+		shift = reduce.shift[i];
+		n = N[i] >> shift;
+
+		if(reduce.mode == REDUCE_AVERAGE) {
+			for(k = 0; k < n; k++) {
+				sum = 0;
+				for(j = 0; j < (1u << shift); j++)
+					sum += (int)*in++;
+				*out++ = (unsigned int)(int)(sum >> shift);
+			}
+		} else {
+			for(k = 0; k < n; k++) {
+				*out++ = *in;
+				in += 1u << shift;
+			}
+		}
+
+		in += N[i] - (n << shift);						// leftover samples
+		((strRtspChannelHeader *)dst)->N[i] = n;
+		total += n;
+	}
+
+	((strRtspChannelHeader *)dst)->channelSize = (RTSP_CHANNEL_HEADER_WORDS - 1) + total;
+
+	if(total < samples)
+		reduce.channelsReduced++;
+
+	return RTSP_CHANNEL_HEADER_WORDS + total;
+}
+
+/*****************************************************************************/
+/**
+ * @brief reduce a frame in place
+ * This function reduces every channel of a frame and closes up the gaps, so
+ * the frame stays contiguous and can be sent from where it is.  dataSize,
+ * channelSize and N[] are rewritten to match.
+ *
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	size holds the frame size in bytes
+ *
+ * @return	new frame size in bytes
+ *
+ * @note 	a changed frame is marked dirty for the next cacheCommit()
+ *
+******************************************************************************/
+HOT_CODE unsigned int reduceFrame(u8 *frame, unsigned int size) {
+
+	unsigned int saved;
+
+	if(reduce.mode == REDUCE_OFF)
+		return size;
+
+	saved = rtspShrinkFrame(frame, reduceChannel);
+
+	if(saved == 0)
+		return size;
+
+	reduce.framesReduced++;
+	reduce.wordsSaved += saved;
+
+	size = rtspFrameSize((strRtspFrameHeader *)(frame + RTSP_SYNC_SIZE));
+
+	cacheDirty(frame, size);
+
+	return size;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the reduction settings and counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayReduce(void) {
+
+	int i;
+
+	if(reduce.mode == REDUCE_OFF) {
+		xil_printf("\nReduction off\n");
+		return;
+	}
+
+	xil_printf("\nMode \t\t\t- %s\n", (reduce.mode == REDUCE_AVERAGE) ? "average" : "decimate");
+	xil_printf("Factors \t\t-");
+	for(i = 0; i < REDUCE_RANGES; i++)
+		xil_printf(" %d", 1 << reduce.shift[i]);
+	xil_printf("\nFrames reduced \t\t- %d\n", reduce.framesReduced);
+	xil_printf("Channels reduced \t- %d\n", reduce.channelsReduced);
+	xil_printf("Channels skipped \t- %d\n", reduce.channelsSkipped);
+	xil_printf("Words saved \t\t- %d\n", reduce.wordsSaved);
+}
@@ -0,0 +1,38 @@
+/*
+ * @file reduce.h
+ */
+
+#ifndef REDUCE_H_
+#define REDUCE_H_
+
+#include "common.h"
+
+#define REDUCE_OFF			0			// frames go out at full resolution
+#define REDUCE_DECIMATE		1			// keep the first sample of each group
+#define REDUCE_AVERAGE		2			// boxcar average of each group
+
+#define REDUCE_RANGES		8			// size of D[] and N[]
+#define REDUCE_ALL_RANGES	0xFF		// apply a factor to every range
+#define REDUCE_MAX_SHIFT	8			// largest factor is 256
+
+/**
+ * @struct reduce_struct
+ * @brief range reduction settings and counters
+ *
+ * factors are powers of 2 and held as shifts so averaging never divides
+ */
+typedef struct reduce_type {
+	unsigned int	mode;						//!< REDUCE_OFF/DECIMATE/AVERAGE
+	unsigned int	shift[REDUCE_RANGES];		//!< log2 of the factor for each range
+	unsigned int	framesReduced;				//!< frames made smaller
+	unsigned int	channelsReduced;			//!< channels made smaller
+	unsigned int	channelsSkipped;			//!< channels with N[] not matching channelSize
+	unsigned int	wordsSaved;					//!< words taken off the aurora
+} reduce_struct;
+
+void reduceInit(void);
+int reduceSet(unsigned int, unsigned int, unsigned int);
+unsigned int reduceFrame(u8 *, unsigned int);
+void displayReduce(void);
+
+#endif /* REDUCE_H_ */
@@ -0,0 +1,200 @@
+/*
+ * @file replay.c
+ * @brief timed playback of frames over the aurora
+ */
+
+#include <string.h>
+
+#include "replay.h"
+#include "capture.h"
+#include "rtsp.h"
+#include "timer.h"
+#include "shaper.h"
+#include "dma.h"
+#include "interrupt.h"
+#include "cache.h"
+#include "crc.h"
+#include "pool.h"
+
+/*****************************************************************************/
+/**
+ * @brief wait for a frame's transmit time
+ * This function spins on the AXI timer until the due time.  If we are already
+ * late the schedule is moved up to now so a slow frame does not turn into a
+ * burst of back to back frames.
+ *
+ * @param	due is a pointer to the due time in timer ticks
+ *
+ * @return	timer ticks when the wait ended
+ *
+ * @note 	none
+ *
+******************************************************************************/
+static unsigned int replayWait(unsigned int *due) {
+
+	unsigned int now;
+
+	now = timerGetTicks();
+
+	if((int)(*due - now) <= 0) {
+		*due = now;
+		return now;
+	}
+
+	while((int)((now = timerGetTicks()) - *due) < 0) {
+		/* NOP */
+	}
+
+	return now;
+}
+
+/*****************************************************************************/
+/**
+ * @brief replay frames over the aurora
+ * This function streams frames from DDR out through the AXI DMA, either from
+ * the capture ring (oldest first) or from a region of frames packed back to
+ * back, each starting with its sync word.  Frames are paced from the AXI
+ * timer at a fixed rate or with the gaps between the capture timestamps.
+ *
+ *    DDR --> AXI DMA --> Aurora
+ *
+ * @param	p is a pointer to the parameters structure
+ * @param	r is a pointer to the replay configuration
+ *
+ * @return	success/failure
+ *
+ * @note 	with CRC trailers on each frame is copied to the transmit buffer
+ * 			and signed there, there is no room for a trailer where it is kept.
+ * 			preloaded frames are written by the host over PCIe.  they have no
+ * 			timestamps and always use the fixed rate, and each is read from
+ * 			DDR and checked with rtspValidate() before it is sent.  runs
+ * 			until the passes are done or a key is pressed.
+ *
+******************************************************************************/
+int runReplay(params_struct *p, replay_struct *r) {
+
+	int status = XST_SUCCESS;
+	unsigned int i, frames, pass, size;
+	unsigned int interval, due, now, lastTicks;
+	unsigned int sent = 0;
+	u64 elapsed = 0;
+	u8 *frame;
+	u8 *savedTxBuffer;
+	capture_index_struct *entry;
+	capture_index_struct *previous;
+
+	if(r->source == REPLAY_SOURCE_CAPTURE) {
+		frames = captureCount();
+		if(r->frames && (r->frames < frames))
+			frames = r->frames;
+	} else
+		frames = r->frames;
+
+	if(frames == 0) {
+		xil_printf("Nothing to replay\n");
+		return XST_FAILURE;
+	}
+
+	interval = r->rate ? (TIMER_CLOCK_HZ / r->rate) : 0;
+
+	savedTxBuffer = p->pTxBuffer;
+
+	clearInterruptFlags();
+
+	XAxiDma_IntrEnable(p->pAxiDma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DMA_TO_DEVICE);
+
+	enableInterrupts(p, AXIDMA_TX_INTERRUPT);
+
+	xil_printf("Replaying %d frames (Press any key to quit)\n", frames);
+
+	lastTicks = timerGetTicks();
+	due = lastTicks;
+
+	for(pass = 0; (r->passes == 0) || (pass < r->passes); pass++) {
+
+		frame = r->address;
+		previous = NULL;
+
+		for(i = 0; i < frames; i++) {
+
+			if(p->pUART->status & 0x00000001)			// check for key press
+				break;
+
+			if(r->source == REPLAY_SOURCE_CAPTURE) {
+				entry = captureGetEntry(frames - 1 - i);
+				frame = captureGetFrame(entry);
+				size = entry->length;
+
+				if((r->timing == REPLAY_TIMING_RECORDED) && (previous != NULL))
+					due += entry->timestamp - previous->timestamp;
+				else
+					due += interval;
+
+				previous = entry;
+			} else {
+				/*
+				 * the host wrote the frames behind the cache, read the header
+				 * from DDR and then the rest once it is sized
+				 */
+				cacheInvalidate(frame, RTSP_SYNC_SIZE + sizeof(strRtspFrameHeader));
+
+				if(rtspValidate(p, frame, RTSP_MAX_FRAME_SIZE) != RTSP_VALID) {
+					xil_printf("Bad frame at 0x%08X\n", (unsigned int)frame);
+					status = XST_FAILURE;
+					break;
+				}
+				size = rtspFrameSize((strRtspFrameHeader *)(frame + RTSP_SYNC_SIZE));
+
+				cacheInvalidate(frame, size);
+
+				due += interval;
+			}
+
+			now = replayWait(&due);
+
+			shaperWait(size);
+
+			elapsed += now - lastTicks;
+			lastTicks = now;
+
+			p->pTxBuffer = frame;
+			p->testPacketSize = size;
+
+			/*
+			 * frames are captured and preloaded without a trailer, sign a
+			 * copy in the transmit buffer as the forwarding path would
+			 */
+			if(crcEnabled() && (size <= (poolBufferSize(POOL_DMA) - CRC_TRAILER_SIZE))) {
+				memcpy(savedTxBuffer, frame, size);
+
+				p->pTxBuffer = savedTxBuffer;
+				p->testPacketSize = crcAppend(savedTxBuffer, size);
+
+				cacheFlush(savedTxBuffer, p->testPacketSize);
+			} else if(r->source == REPLAY_SOURCE_CAPTURE)
+				cacheFlush(frame, size);					// captured by the CPU
+
+			status = sendDMA(p);
+			if ((status != XST_SUCCESS) || Error) {
+				status = XST_FAILURE;
+				break;
+			}
+
+			sent++;
+
+			if(r->source == REPLAY_SOURCE_PRELOAD)
+				frame += (size + 3) & ~3;
+		}
+
+		if((i < frames) || (status != XST_SUCCESS))
+			break;
+	}
+
+	p->pTxBuffer = savedTxBuffer;
+
+	disableInterrupts(p, ALL_INTERRUPTS);
+
+	xil_printf("\n%d frames replayed in %d ms\n", sent, (unsigned int)(elapsed / (TIMER_CLOCK_HZ / 1000)));
+
+	return status;
+}
@@ -0,0 +1,31 @@
+/*
+ * @file replay.h
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "common.h"
+
+#define REPLAY_SOURCE_CAPTURE	0		// frames from the capture ring
+#define REPLAY_SOURCE_PRELOAD	1		// frames packed back to back in DDR
+
+#define REPLAY_TIMING_RATE		0		// fixed frame rate
+#define REPLAY_TIMING_RECORDED	1		// original capture timestamps
+
+/**
+ * @struct replay_struct
+ * @brief replay configuration
+ */
+typedef struct replay_type {
+	unsigned int source;				//!< REPLAY_SOURCE_CAPTURE/PRELOAD
+	u8 *		 address;				//!< first frame for REPLAY_SOURCE_PRELOAD
+	unsigned int frames;				//!< frames per pass, 0-whole capture ring
+	unsigned int timing;				//!< REPLAY_TIMING_RATE/RECORDED
+	unsigned int rate;					//!< frames per second, 0-line rate
+	unsigned int passes;				//!< passes over the frames, 0-until key press
+} replay_struct;
+
+int runReplay(params_struct *, replay_struct *);
+
+#endif /* REPLAY_H_ */
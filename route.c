@@ -0,0 +1,167 @@
+/*
+ * @file route.c
+ * @brief shelf/channel routing table
+ */
+
+#include "route.h"
+#include "rtsp.h"
+
+/*
+ * one byte per shelf/channel pair, kept in .bss which the linker script
+ * places in local BRAM so a lookup costs a single LMB read
+ */
+static u8 routeTable[ROUTE_MAX_SHELVES][ROUTE_MAX_CHANNELS];
+static u8 routeDefault;
+static int routeIsEnabled;
+
+/*****************************************************************************/
+/**
+ * @brief initialize the routing table
+ * This function sets every entry, and the route used for shelves and channels
+ * outside the table, to the same destination set
+ *
+ * @param	dest holds the default destination set
+ *
+ * @return	none
+ *
+ * @note 	the table is left disabled
+ *
+******************************************************************************/
+void routeInit(u8 dest) {
+
+	unsigned int shelf, channel;
+
+	for(shelf = 0; shelf < ROUTE_MAX_SHELVES; shelf++)
+		for(channel = 0; channel < ROUTE_MAX_CHANNELS; channel++)
+			routeTable[shelf][channel] = dest;
+
+	routeDefault = dest;
+	routeIsEnabled = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief set a routing table entry
+ *
+ * @param	shelf holds the shelf ID
+ * @param	channel holds the channel number
+ * @param	dest holds the OR'ed destination set
+ *
+ * @return	success/failure
+ *
+ * @note 	none
+ *
+******************************************************************************/
+int routeSet(unsigned int shelf, unsigned int channel, u8 dest) {
+
+	if((shelf >= ROUTE_MAX_SHELVES) || (channel >= ROUTE_MAX_CHANNELS))
+		return XST_FAILURE;
+
+	routeTable[shelf][channel] = dest;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief look up a shelf/channel pair
+ *
+ * @param	shelf holds the shelf ID
+ * @param	channel holds the channel number
+ *
+ * @return	destination set
+ *
+ * @note 	pairs outside the table get the default route
+ *
+******************************************************************************/
+HOT_CODE u8 routeLookup(unsigned int shelf, unsigned int channel) {
+
+	if((shelf >= ROUTE_MAX_SHELVES) || (channel >= ROUTE_MAX_CHANNELS))
+		return routeDefault;
+
+	return routeTable[shelf][channel];
+}
+
+/*****************************************************************************/
+/**
+ * @brief route a frame
+ * This function looks up every channel in the frame.  A frame goes to each
+ * destination that any of its channels is routed to.
+ *
+ * @param	header is a pointer to the RTSP frame header
+ *
+ * @return	destination set
+ *
+ * @note 	a frame without channels gets the default route
+ *
+******************************************************************************/
+HOT_CODE u8 routeFrame(strRtspFrameHeader *header) {
+
+	strRtspChannelHeader *channel;
+	u8 dest = ROUTE_DROP;
+
+	channel = rtspFirstChannel(header);
+
+	if(channel == NULL)
+		return routeDefault;
+
+	while(channel != NULL) {
+		dest |= routeLookup(header->shelfID, channel->channelNumber);
+		channel = rtspNextChannel(header, channel);
+	}
+
+	return dest;
+}
+
+/*****************************************************************************/
+/**
+ * @brief enable or disable the routing table
+ *
+ * @param	enable 1-route by table, 0-route by shelf ID only
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+void routeEnable(int enable) {
+
+	routeIsEnabled = enable;
+}
+
+/*****************************************************************************/
+/**
+ * @brief check if the routing table is enabled
+ *
+ * @return	1-enabled, 0-disabled
+ *
+ * @note 	none
+ *
+******************************************************************************/
+int routeEnabled(void) {
+
+	return routeIsEnabled;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the routing table
+ * This function displays the entries that differ from the default route
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayRouteTable(void) {
+
+	unsigned int shelf, channel;
+
+	xil_printf("\nRouting table %s (1-aurora, 2-host, 4-capture, 8-priority, 0-drop)\n", routeIsEnabled ? "enabled" : "disabled");
+	xil_printf("default \t\t- %d\n", routeDefault);
+
+	for(shelf = 0; shelf < ROUTE_MAX_SHELVES; shelf++)
+		for(channel = 0; channel < ROUTE_MAX_CHANNELS; channel++)
+			if(routeTable[shelf][channel] != routeDefault)
+				xil_printf("shelf %d channel %d \t- %d\n", shelf, channel, routeTable[shelf][channel]);
+}
@@ -0,0 +1,30 @@
+/*
+ * @file route.h
+ */
+
+#ifndef ROUTE_H_
+#define ROUTE_H_
+
+#include "common.h"
+
+/*
+ * destinations, OR'ed together to make a destination set
+ */
+#define ROUTE_DROP			0x00		// discard the frame
+#define ROUTE_AURORA		0x01		// aurora transmit
+#define ROUTE_HOST			0x02		// host return path
+#define ROUTE_CAPTURE		0x04		// DDR capture ring
+#define ROUTE_PRIORITY		0x08		// aurora transmit at high priority
+
+#define ROUTE_MAX_SHELVES	16
+#define ROUTE_MAX_CHANNELS	32
+
+void routeInit(u8);
+int routeSet(unsigned int, unsigned int, u8);
+u8 routeLookup(unsigned int, unsigned int);
+u8 routeFrame(strRtspFrameHeader *);
+void routeEnable(int);
+int routeEnabled(void);
+void displayRouteTable(void);
+
+#endif /* ROUTE_H_ */
@@ -0,0 +1,598 @@
+/*
+ * @file rtsp.c
+ * @brief RTSP frame handling and daisy-chain forwarding
+ */
+
+#include "rtsp.h"
+#include "route.h"
+#include "filter.h"
+#include "capture.h"
+#include "shaper.h"
+#include "txqueue.h"
+#include "reduce.h"
+#include "pack.h"
+#include "compress.h"
+#include "crc.h"
+#include "rxpool.h"
+#include "interrupt.h"
+#include "dma.h"
+#include "cache.h"
+
+static forward_stats_struct forwardStats;
+
+/*****************************************************************************/
+/**
+ * @brief rewrite the channels of a frame in place
+ * This function hands each channel to rewrite along with where it should be
+ * written, then closes up the frame behind it.  rewrite must write the whole
+ * channel, header first, and may make it smaller but never larger, so the
+ * frame can be sent from where it is.  Anything after the last good channel
+ * is moved down unchanged and dataSize is fixed up.
+ *
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	rewrite is the channel function, it returns the words it wrote
+ *
+ * @return	number of words the frame shrank by
+ *
+ * @note 	dst is never past the channel, rewrite has to read a word before
+ * 			it writes over it
+ *
+******************************************************************************/
+HOT_CODE unsigned int rtspShrinkFrame(u8 *frame, unsigned int (*rewrite)(strRtspChannelHeader *, unsigned int *)) {
+
+	strRtspFrameHeader *header = (strRtspFrameHeader *)(frame + RTSP_SYNC_SIZE);
+	strRtspChannelHeader *channel;
+	strRtspChannelHeader *next;
+	unsigned int *payload = (unsigned int *)(header + 1);
+	unsigned int *end;
+	unsigned int *in;
+	unsigned int *out;
+	unsigned int saved;
+
+	end = (unsigned int *)(frame + rtspFrameSize(header));
+	in = payload;
+	out = payload;
+
+	channel = rtspFirstChannel(header);
+
+	while(channel != NULL) {
+
+		next = rtspNextChannel(header, channel);		// before the channel is rewritten
+
+		if((&channel->channelSize + channel->channelSize) > (payload + header->dataSize))
+			break;
+
+		in = &channel->channelSize + channel->channelSize;
+		out += rewrite(channel, out);
+
+		channel = next;
+	}
+
+	saved = in - out;
+
+	if(saved == 0)
+		return 0;
+
+	while(in < end)
+		*out++ = *in++;
+
+	header->dataSize -= saved;
+
+	return saved;
+}
+
+/*****************************************************************************/
+/**
+ * @brief rewrite the channels of a frame into a second buffer
+ * This function hands each channel to expand along with where it should be
+ * written in dst and the words left there.  Anything after the last good
+ * channel is copied unchanged and dataSize is fixed up.
+ *
+ * @param	src is a pointer to the start of the frame (sync word)
+ * @param	dst is a pointer to the buffer for the expanded frame
+ * @param	dstSize holds the bytes in dst
+ * @param	expand is the channel function, it returns the words it wrote or
+ * 			RTSP_EXPAND_FULL if the channel would not fit
+ *
+ * @return	size of the new frame in bytes, 0 if it would not fit in dst
+ *
+ * @note 	src is not changed
+ *
+******************************************************************************/
+HOT_CODE unsigned int rtspExpandFrame(u8 *src, u8 *dst, unsigned int dstSize,
+		unsigned int (*expand)(strRtspChannelHeader *, unsigned int *, unsigned int)) {
+
+	strRtspFrameHeader *header = (strRtspFrameHeader *)(src + RTSP_SYNC_SIZE);
+	strRtspFrameHeader *dstHeader = (strRtspFrameHeader *)(dst + RTSP_SYNC_SIZE);
+	strRtspChannelHeader *channel;
+	unsigned int *payload = (unsigned int *)(header + 1);
+	unsigned int *end;
+	unsigned int *in;
+	unsigned int *out;
+	unsigned int *limit;
+	unsigned int i, words;
+
+	if(dstSize < RTSP_MIN_FRAME_SIZE)
+		return 0;
+
+	for(i = 0; i < (RTSP_SYNC_SIZE + sizeof(strRtspFrameHeader)) / 4; i++)
+		((unsigned int *)dst)[i] = ((unsigned int *)src)[i];
+
+	end = (unsigned int *)(src + rtspFrameSize(header));
+	in = payload;
+	out = (unsigned int *)(dstHeader + 1);
+	limit = (unsigned int *)(dst + (dstSize & ~3));
+
+	for(channel = rtspFirstChannel(header); channel != NULL; channel = rtspNextChannel(header, channel)) {
+
+		if((&channel->channelSize + channel->channelSize) > (payload + header->dataSize))
+			break;
+
+		in = &channel->channelSize + channel->channelSize;
+
+		words = expand(channel, out, limit - out);
+		if(words == RTSP_EXPAND_FULL)
+			return 0;
+
+		out += words;
+	}
+
+	if((end - in) > (limit - out))
+		return 0;
+
+	dstHeader->dataSize = header->dataSize + (out - (unsigned int *)(dstHeader + 1)) - (in - payload);
+
+	while(in < end)
+		*out++ = *in++;
+
+	return rtspFrameSize(dstHeader);
+}
+
+/*****************************************************************************/
+/**
+ * @brief check a frame header before the frame is used
+ * This function rejects a frame whose header cannot be trusted, before its
+ * dataSize is used to size a transfer.  The checks are rtspCheckFrame(),
+ * this adds the counters.
+ *
+ * @param	p is a pointer to the parameters structure
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	maxSize holds the bytes in the buffer, or received
+ *
+ * @return	RTSP_VALID or the first check that failed
+ *
+ * @note 	rejected frames are counted in the forwarding stats
+ *
+******************************************************************************/
+HOT_CODE int rtspValidate(params_struct *p, u8 *frame, unsigned int maxSize) {
+
+	int result = rtspCheckFrame(frame, maxSize, p->headerID);
+
+	switch(result) {
+		case RTSP_BAD_SIZE:
+			forwardStats.badSize++;
+			break;
+		case RTSP_BAD_SYNC:
+			forwardStats.badSync++;
+			break;
+		case RTSP_BAD_HEADER_ID:
+			forwardStats.badHeaderID++;
+			break;
+		case RTSP_BAD_CHANNEL:
+			forwardStats.badChannel++;
+			break;
+		default:
+			break;
+	}
+
+	return result;
+}
+
+/*****************************************************************************/
+/**
+ * @brief route a frame
+ * This function returns the destination set for a frame.  Frames rejected by
+ * the filter are dropped.  When the routing table is enabled it decides,
+ * otherwise frames for this shelf go to the host and everything else goes out
+ * of the aurora.  Either way every frame that is not dropped is captured
+ * while recording is enabled.
+ *
+ * @param	p is a pointer to the parameters structure
+ * @param	header is a pointer to the RTSP frame header
+ *
+ * @return	OR'ed destination set
+ *
+ * @note 	table entries do not need ROUTE_CAPTURE for capture or the
+ * 			triggers to see a frame
+ *
+******************************************************************************/
+HOT_CODE u8 rtspRoute(params_struct *p, strRtspFrameHeader *header) {
+
+	u8 dest;
+
+	if(!filterFrame(header))
+		return ROUTE_DROP;
+
+	if(routeEnabled())
+		dest = routeFrame(header);
+	else if(forwardDecision(header, p->shelfID) == RTSP_CONSUME)
+		dest = ROUTE_HOST;
+	else
+		dest = ROUTE_AURORA;
+
+	if((dest != ROUTE_DROP) && captureEnabled())
+		dest |= ROUTE_CAPTURE;
+
+	return dest;
+}
+
+/*****************************************************************************/
+/**
+ * @brief deliver a frame to its local destinations
+ * This function handles every destination except the aurora, which is left
+ * to the caller so it can choose how to wait for the transmit.  A destination
+ * that keeps a forwarding frame after this returns, rather than copying it,
+ * takes a hold on its slot with rxPoolHold().
+ *
+ * @param	p is a pointer to the parameters structure
+ * @param	dest holds the destination set from rtspRoute()
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	size holds the frame size in bytes
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE void rtspDeliverFrame(params_struct *p, u8 dest, u8 *frame, unsigned int size) {
+
+	if(dest == ROUTE_DROP) {
+		rtspDropFrame(p, frame, size);
+		return;
+	}
+
+	if(dest & ROUTE_CAPTURE)
+		captureFrame(frame, size);
+
+	if(dest & ROUTE_HOST)
+		rtspConsumeFrame(p, frame, size);
+}
+
+/*****************************************************************************/
+/**
+ * @brief consume a frame addressed to this shelf
+ * This function takes ownership of a frame that is not forwarded.
+ *
+ * @param	p is a pointer to the parameters structure
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	size holds the frame size in bytes
+ *
+ * @return	none
+ *
+ * @note 	there is no host return path yet, so the frame is only counted.
+ * 			the path will have to decompressFrame() then unpackFrame(), the
+ * 			reverse of the transmit order, into buffers it passes the size of.
+ *
+******************************************************************************/
+HOT_CODE void rtspConsumeFrame(params_struct *p, u8 *frame, unsigned int size) {
+
+	forwardStats.framesConsumed++;
+}
+
+/*****************************************************************************/
+/**
+ * @brief drop a frame
+ * This function accounts for a frame that is routed nowhere
+ *
+ * @param	p is a pointer to the parameters structure
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	size holds the frame size in bytes
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE void rtspDropFrame(params_struct *p, u8 *frame, unsigned int size) {
+
+	forwardStats.framesDropped++;
+}
+
+/*****************************************************************************/
+/**
+ * @brief put the sync word in front of a frame
+ * This function writes the sync word into the header slot just before the
+ * frame goes out, so frames can be built and stored without it.  Frames that
+ * already carry it, forwarded frames and the host buffer after its first
+ * frame, are only read, so a buffer the DMA may be reading is not dirtied
+ * and no flush is needed.
+ *
+ * @param	frame is a pointer to the start of the frame (sync word)
+ *
+ * @return	none
+ *
+ * @note 	flushes the header line at once, the host writes the rest of its
+ * 			buffer straight after
+ *
+******************************************************************************/
+HOT_CODE void rtspSupplySync(u8 *frame) {
+
+	if(*(unsigned int *)frame == RTSP_SYNC_WORD)
+		return;
+
+	*(unsigned int *)frame = RTSP_SYNC_WORD;
+
+	cacheFlush(frame, RTSP_SYNC_SIZE);
+}
+
+/*****************************************************************************/
+/**
+ * @brief transmit a frame on the aurora
+ * This function waits for the rate shaper, supplies the sync word and starts
+ * the AXI DMA transmit
+ *
+ * @param	p is a pointer to the parameters structure
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	size holds the frame size in bytes
+ *
+ * @return	success/failure
+ *
+ * @note 	does not wait for the transmit to complete
+ *
+******************************************************************************/
+HOT_CODE int rtspTransmit(params_struct *p, u8 *frame, unsigned int size) {
+
+	shaperWait(size);
+
+	rtspSupplySync(frame);
+
+	return dmaTransfer(p->pAxiDma, frame, size, XAXIDMA_DMA_TO_DEVICE);
+}
+
+/*****************************************************************************/
+/**
+ * @brief run daisy-chain forwarding
+ * This function receives frames from the aurora, keeps the frames addressed
+ * to this shelf and sends the rest back out of the aurora untouched.  The
+ * received buffer is transmitted in place, the payload is never copied.
+ *
+ *    upstream --> Aurora --> AXI DMA --> DDR --> AXI DMA --> Aurora --> downstream
+ *                                         |
+ *                                          --> this shelf
+ *
+ * Frames are received into FORWARD_SLOTS buffers from the receive pool, laid
+ * out so the payload starts on a FRAME_ALIGN boundary, and wait in the
+ * priority transmit queues, so the receive stays armed while earlier frames
+ * are being sent.  Each holder of a slot has a reference and the slot goes
+ * back to the S2MM when the last one lets go.
+ *
+ * Nothing in the loop blocks: each pass re-arms the receive, routes an
+ * arrived frame, retires a finished transmit and starts the next one the
+ * scheduler and the rate shaper allow.  Frames for the aurora are range
+ * reduced, packed and compressed after this shelf and the capture ring have
+ * had the full frame.  A CRC trailer is checked on the way in, frames that
+ * fail are dropped, and a new one is added on the way out.  A transmit that
+ * misses its watchdog deadline is cancelled with an engine reset.  The
+ * receive is not watched, as no traffic upstream is not a fault.
+ *
+ * @param	p is a pointer to the parameters structure
+ *
+ * @return	success/failure
+ *
+ * @note 	runs until a key is pressed or the AXI DMA cannot be recovered
+ * 			from an error
+ *
+******************************************************************************/
+HOT_CODE int runForwarding(params_struct *p) {
+
+	int status = XST_SUCCESS;
+	int state;
+	int class;
+	unsigned int frameSize;
+	u8 dest;
+	u8 *slot;
+	u8 *rxFrame = NULL;								// frame the S2MM is filling
+	u8 *txFrame = NULL;								// frame the MM2S is sending
+	txq_entry_struct *next;
+	strRtspFrameHeader *header;
+
+	rxPoolInit(POOL_FORWARD);
+
+	txqFlush();
+
+	forwardStats.framesReceived = 0;
+	forwardStats.framesForwarded = 0;
+	forwardStats.framesConsumed = 0;
+	forwardStats.framesDropped = 0;
+	forwardStats.badSize = 0;
+	forwardStats.badSync = 0;
+	forwardStats.badHeaderID = 0;
+	forwardStats.badChannel = 0;
+
+	clearInterruptFlags();
+
+	XAxiDma_IntrEnable(p->pAxiDma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DMA_TO_DEVICE);
+	XAxiDma_IntrEnable(p->pAxiDma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DEVICE_TO_DMA);
+
+	enableInterrupts(p, AXIDMA_TX_INTERRUPT | AXIDMA_RX_INTERRUPT);
+
+	xil_printf("Forwarding for shelf %d (Press any key to quit)\n", p->shelfID);
+
+	while(!(p->pUART->status & 0x00000001)) {			// check for key press
+
+		/*
+		 * a transmit the link never takes is cancelled by the recovery reset
+		 */
+		if((txFrame != NULL) && !TxDone && dmaWatchdogExpired(DMA_WATCH_MM2S))
+			Error = 1;
+
+		/*
+		 * an engine error loses whatever was in flight, reset the engine
+		 * and carry on once it is back
+		 */
+		if (Error) {
+			triggerPoll(p);
+
+			state = dmaRecover(p->pAxiDma);
+
+			if (state == DMA_RECOVERY_FAILED) {
+				xil_printf("DMA ERROR - engine did not recover, forwarding stopped\n");
+				status = XST_FAILURE;
+				break;
+			}
+
+			if (state != DMA_RECOVERY_READY)
+				continue;
+
+			if (rxFrame != NULL) {
+				rxPoolRelease(rxFrame);
+				rxFrame = NULL;
+			}
+
+			if (txFrame != NULL) {
+				rxPoolRelease(txFrame);
+				txFrame = NULL;
+			}
+		}
+
+		/*
+		 * keep the receive armed while there is a free slot
+		 */
+		if((rxFrame == NULL) && ((slot = rxPoolGet()) != NULL)) {
+			rxFrame = slot + RTSP_FRAME_OFFSET;
+
+			RxDone = 0;
+
+			status = dmaTransfer(p->pAxiDma, rxFrame, RTSP_MAX_FRAME_SIZE + CRC_TRAILER_SIZE, XAXIDMA_DEVICE_TO_DMA);
+			if (status != XST_SUCCESS) {
+				if (Error)
+					continue;						// the engine halted, recover first
+				break;
+			}
+		}
+
+		/*
+		 * a frame has arrived, route it
+		 */
+		if((rxFrame != NULL) && RxDone) {
+
+			triggerPoll(p);
+
+			frameSize = dmaReceiveComplete(p->pAxiDma);
+
+			forwardStats.framesReceived++;
+
+			header = (strRtspFrameHeader *)(rxFrame + RTSP_SYNC_SIZE);
+
+			if((rtspValidate(p, rxFrame, frameSize) != RTSP_VALID) || (crcCheck(rxFrame, &frameSize) == CRC_BAD))
+				dest = ROUTE_DROP;
+			else
+				dest = rtspRoute(p, header);
+
+			rtspDeliverFrame(p, dest, rxFrame, frameSize);
+
+			if(dest & ROUTE_AURORA) {
+				class = txqClassify(header, dest);			// on the size received, before it is rewritten
+
+				frameSize = reduceFrame(rxFrame, frameSize);
+				frameSize = packFrame(rxFrame, frameSize);
+				frameSize = compressFrame(rxFrame, frameSize);
+				frameSize = crcAppend(rxFrame, frameSize);
+
+				/*
+				 * the transmit queue holds the slot until the frame is sent,
+				 * then the receive lets go of it
+				 */
+				if(txqPut(class, rxFrame, frameSize) == XST_SUCCESS)
+					rxPoolHold(rxFrame);
+			}
+
+			rxPoolRelease(rxFrame);
+			rxFrame = NULL;
+
+			if((forwardStats.framesReceived % 100) == 0)
+				xil_printf(".");
+		}
+
+		/*
+		 * the last transmit has finished, let go of its slot
+		 */
+		if((txFrame != NULL) && TxDone) {
+			dmaWatchdogDisarm(DMA_WATCH_MM2S);
+
+			rxPoolRelease(txFrame);
+			txFrame = NULL;
+
+			forwardStats.framesForwarded++;
+		}
+
+		/*
+		 * start the next transmit
+		 */
+		if((txFrame == NULL) && ((next = txqPeek()) != NULL) && shaperAllow(next->size)) {
+			rtspSupplySync(next->frame);
+
+			TxDone = 0;
+
+			status = dmaTransfer(p->pAxiDma, next->frame, next->size, XAXIDMA_DMA_TO_DEVICE);
+			if (status != XST_SUCCESS) {
+				if (Error)
+					continue;						// still queued, sent after recovery
+				break;
+			}
+
+			dmaWatchdogArm(DMA_WATCH_MM2S);
+
+			txFrame = next->frame;
+			txqPop();
+		}
+	}
+
+	/*
+	 * a transfer is still outstanding if we quit while waiting, reset the engine
+	 */
+	if((rxFrame != NULL) || (txFrame != NULL) || Error)
+		dmaRecoverWait(p->pAxiDma);
+
+	txqFlush();
+
+	disableInterrupts(p, ALL_INTERRUPTS);
+
+	displayForwardStats(p);
+	displayRxPool();
+
+	return status;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the forwarding counters
+ *
+ * @param	p is a pointer to the parameters structure
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayForwardStats(params_struct *p) {
+
+	xil_printf("\nShelf ID \t\t- ");
+	if(p->shelfID == RTSP_SHELF_NONE)
+		xil_printf("none\n");
+	else
+		xil_printf("%d\n", p->shelfID);
+
+	xil_printf("Header ID \t\t- ");
+	if(p->headerID == RTSP_HEADER_ID_ANY)
+		xil_printf("any\n");
+	else
+		xil_printf("0x%08X\n", p->headerID);
+
+	xil_printf("Frames received \t- %d\n", forwardStats.framesReceived);
+	xil_printf("Frames forwarded \t- %d\n", forwardStats.framesForwarded);
+	xil_printf("Frames consumed \t- %d\n", forwardStats.framesConsumed);
+	xil_printf("Frames dropped \t\t- %d\n", forwardStats.framesDropped);
+	xil_printf("Bad size/sync/ID/channel - %d/%d/%d/%d\n", forwardStats.badSize, forwardStats.badSync,
+			forwardStats.badHeaderID, forwardStats.badChannel);
+}
@@ -0,0 +1,40 @@
+/*
+ * @file rtsp.h
+ */
+
+#ifndef RTSP_H_
+#define RTSP_H_
+
+#include "common.h"
+
+#define RTSP_FRAME_OFFSET	(FRAME_HEADER_SLOT - RTSP_SYNC_SIZE - sizeof(strRtspFrameHeader))	// frame start in a slot
+#define RTSP_EXPAND_FULL	0xFFFFFFFF		// an expanded channel would not fit, see rtspExpandFrame()
+
+/**
+ * @struct forward_stats_struct
+ * @brief daisy-chain forwarding counters
+ */
+typedef struct forward_stats_type {
+	unsigned int framesReceived;		//!< frames received from the aurora
+	unsigned int framesForwarded;		//!< frames sent on down the chain
+	unsigned int framesConsumed;		//!< frames addressed to this shelf
+	unsigned int framesDropped;			//!< frames routed nowhere
+	unsigned int badSize;				//!< frames rejected for dataSize
+	unsigned int badSync;				//!< frames rejected for the sync word
+	unsigned int badHeaderID;			//!< frames rejected for headerID
+	unsigned int badChannel;			//!< frames rejected for a channel size
+} forward_stats_struct;
+
+unsigned int rtspShrinkFrame(u8 *, unsigned int (*)(strRtspChannelHeader *, unsigned int *));
+unsigned int rtspExpandFrame(u8 *, u8 *, unsigned int, unsigned int (*)(strRtspChannelHeader *, unsigned int *, unsigned int));
+int rtspValidate(params_struct *, u8 *, unsigned int);
+u8 rtspRoute(params_struct *, strRtspFrameHeader *);
+void rtspDeliverFrame(params_struct *, u8, u8 *, unsigned int);
+void rtspConsumeFrame(params_struct *, u8 *, unsigned int);
+void rtspDropFrame(params_struct *, u8 *, unsigned int);
+void rtspSupplySync(u8 *);
+int rtspTransmit(params_struct *, u8 *, unsigned int);
+int runForwarding(params_struct *);
+void displayForwardStats(params_struct *);
+
+#endif /* RTSP_H_ */
@@ -0,0 +1,193 @@
+/*
+ * @file rtsp_frame.h
+ * @brief RTSP frame layout and the forwarding decision
+ *
+ * Nothing here touches the hardware or the Xilinx headers, so the frame
+ * checks and the shelf decision the forwarding loop makes can be built and
+ * run on a Linux host against simulated link endpoints, see host/.
+ */
+
+#ifndef RTSP_FRAME_H_
+#define RTSP_FRAME_H_
+
+#include <stddef.h>
+
+/*
+ * RTSP frame parameters
+ */
+#define RTSP_SYNC_SIZE		4				// sync word preceding the frame header
+#define RTSP_MAX_FRAME_SIZE	0x00100000		// largest frame accepted from the aurora
+#define RTSP_SHELF_NONE		0xFFFFFFFF		// board is not part of a daisy chain
+#define RTSP_SYNC_WORD		0x90EBBBAA		// AA BB EB 90 read as a word
+#define RTSP_HEADER_ID_ANY	0xFFFFFFFF		// headerID is not checked
+
+#define RTSP_FORWARD	0		// frame belongs to another shelf, send it on
+#define RTSP_CONSUME	1		// frame belongs to this shelf
+
+#define RTSP_VALID			0		// frame header checks out
+#define RTSP_BAD_SIZE		1		// dataSize runs past the buffer
+#define RTSP_BAD_SYNC		2		// sync word missing
+#define RTSP_BAD_HEADER_ID	3		// headerID is not the one expected
+#define RTSP_BAD_CHANNEL	4		// a channel runs past dataSize
+
+typedef struct RTSP_FrameHeader_type {
+	unsigned int	headerID;
+	unsigned int	shelfID;
+	unsigned int	dataSize;
+} strRtspFrameHeader;
+
+typedef struct RTSP_ChannelHeader_type {
+	unsigned int channelNumber; //!< channel number
+	unsigned int channelSize;	//!< number of elements from here to the end of the channel
+	unsigned int W;				//!< number of ranges
+	unsigned int D[8];			//!< ranges
+	unsigned N[8];				//!< samples per range
+}strRtspChannelHeader;
+
+#define RTSP_MIN_FRAME_SIZE	(RTSP_SYNC_SIZE + sizeof(strRtspFrameHeader) + 4)	// dataSize of 0
+
+#define RTSP_CHANNEL_HEADER_WORDS	(sizeof(strRtspChannelHeader) / 4)
+#define RTSP_MAX_RANGES				8		// size of D[] and N[]
+
+/*****************************************************************************/
+/**
+ * @brief RTSP frame size
+ * This function returns the number of bytes on the aurora for a frame,
+ * including the sync word
+ *
+ * @param	header is a pointer to the RTSP frame header
+ *
+ * @return	frame size in bytes
+ *
+ * @note 	none
+ *
+******************************************************************************/
+static inline unsigned int rtspFrameSize(strRtspFrameHeader *header) {
+
+	return ((header->dataSize + 4) * 4) + RTSP_SYNC_SIZE;
+}
+
+/*****************************************************************************/
+/**
+ * @brief first channel of a frame
+ * This function returns the first channel header in the frame payload
+ *
+ * @param	header is a pointer to the RTSP frame header
+ *
+ * @return	pointer to the channel header, NULL if the frame has no channels
+ *
+ * @note 	none
+ *
+******************************************************************************/
+static inline strRtspChannelHeader *rtspFirstChannel(strRtspFrameHeader *header) {
+
+	if(header->dataSize < RTSP_CHANNEL_HEADER_WORDS)
+		return NULL;
+
+	return (strRtspChannelHeader *)(header + 1);
+}
+
+/*****************************************************************************/
+/**
+ * @brief next channel of a frame
+ * This function steps over a channel using its channelSize.  Sizes are checked
+ * against the frame dataSize so a bad channel header cannot walk off the end
+ * of the frame.
+ *
+ * @param	header is a pointer to the RTSP frame header
+ * @param	channel is a pointer to the current channel header
+ *
+ * @return	pointer to the next channel header, NULL after the last channel
+ *
+ * @note 	channelSize counts the words from the channelSize field to the
+ * 			end of the channel
+ *
+******************************************************************************/
+static inline strRtspChannelHeader *rtspNextChannel(strRtspFrameHeader *header, strRtspChannelHeader *channel) {
+
+	unsigned int *payload = (unsigned int *)(header + 1);
+	unsigned int offset;
+
+	if(channel->channelSize < (RTSP_CHANNEL_HEADER_WORDS - 1))
+		return NULL;
+
+	offset = (unsigned int)(&channel->channelSize - payload);
+
+	if(channel->channelSize >= (header->dataSize - offset))
+		return NULL;
+
+	offset += channel->channelSize;
+
+	if((header->dataSize - offset) < RTSP_CHANNEL_HEADER_WORDS)
+		return NULL;
+
+	return (strRtspChannelHeader *)(payload + offset);
+}
+
+/*****************************************************************************/
+/**
+ * @brief check a frame
+ * This function checks dataSize against the buffer before anything trusts
+ * it, then the sync word, the header ID and that every channel stays inside
+ * the frame.
+ *
+ * @param	frame is a pointer to the start of the frame (sync word)
+ * @param	maxSize holds the bytes available at frame
+ * @param	headerID holds the header ID expected, RTSP_HEADER_ID_ANY for any
+ *
+ * @return	RTSP_VALID or the RTSP_BAD_* reason
+ *
+ * @note 	rtspValidate() counts the rejects
+ *
+******************************************************************************/
+static inline int rtspCheckFrame(unsigned char *frame, unsigned int maxSize, unsigned int headerID) {
+
+	strRtspFrameHeader *header = (strRtspFrameHeader *)(frame + RTSP_SYNC_SIZE);
+	strRtspChannelHeader *channel;
+	strRtspChannelHeader *next;
+	unsigned int *payload = (unsigned int *)(header + 1);
+
+	if((maxSize < RTSP_MIN_FRAME_SIZE) ||
+			(header->dataSize > ((maxSize - RTSP_MIN_FRAME_SIZE) / 4)))	// rtspFrameSize() > maxSize, without the overflow
+		return RTSP_BAD_SIZE;
+
+	if(*(unsigned int *)frame != RTSP_SYNC_WORD)
+		return RTSP_BAD_SYNC;
+
+	if((headerID != RTSP_HEADER_ID_ANY) && (header->headerID != headerID))
+		return RTSP_BAD_HEADER_ID;
+
+	for(channel = rtspFirstChannel(header); channel != NULL; channel = next) {
+		next = rtspNextChannel(header, channel);
+
+		if((channel->channelSize < (RTSP_CHANNEL_HEADER_WORDS - 1)) ||
+				((&channel->channelSize + channel->channelSize) > (payload + header->dataSize)))
+			return RTSP_BAD_CHANNEL;
+	}
+
+	return RTSP_VALID;
+}
+
+/*****************************************************************************/
+/**
+ * @brief decide what to do with a frame
+ * This function compares the shelf ID in the frame header with the shelf ID
+ * of this board.  It touches nothing but the header.
+ *
+ * @param	header is a pointer to the RTSP frame header
+ * @param	shelfID holds the shelf ID of this board
+ *
+ * @return	RTSP_CONSUME/RTSP_FORWARD
+ *
+ * @note 	a board with shelf ID RTSP_SHELF_NONE forwards everything
+ *
+******************************************************************************/
+static inline int forwardDecision(strRtspFrameHeader *header, unsigned int shelfID) {
+
+	if((shelfID != RTSP_SHELF_NONE) && (header->shelfID == shelfID))
+		return RTSP_CONSUME;
+
+	return RTSP_FORWARD;
+}
+
+#endif /* RTSP_FRAME_H_ */
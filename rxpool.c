@@ -0,0 +1,130 @@
+/*
+ * @file rxpool.c
+ * @brief reference counted receive buffers over a frame pool
+ */
+
+#include "rxpool.h"
+
+static rxpool_struct rxPool;
+
+/*****************************************************************************/
+/**
+ * @brief set up the receive pool
+ * This function gives every buffer in the frame pool back with no holders
+ *
+ * @param	pool holds the frame pool the buffers come from
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+void rxPoolInit(int pool) {
+
+	unsigned int i;
+
+	poolReset(pool);
+
+	rxPool.pool = pool;
+
+	for(i = 0; i < POOL_MAX_BUFFERS; i++)
+		rxPool.refs[i] = 0;
+
+	rxPool.badRelease = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief take a free buffer
+ *
+ * @return	pointer to the buffer, NULL if none are free
+ *
+ * @note 	the caller holds the only reference
+ *
+******************************************************************************/
+HOT_CODE u8 *rxPoolGet(void) {
+
+	u8 *buffer;
+
+	buffer = poolAlloc(rxPool.pool);
+	if(buffer != NULL)
+		rxPool.refs[poolIndex(rxPool.pool, buffer)] = 1;
+
+	return buffer;
+}
+
+/*****************************************************************************/
+/**
+ * @brief add a holder to a buffer
+ * This function lets another consumer keep a frame without copying it
+ *
+ * @param	buffer is a pointer anywhere inside the buffer
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE void rxPoolHold(u8 *buffer) {
+
+	int n = poolIndex(rxPool.pool, buffer);
+
+	if(n >= 0)
+		rxPool.refs[n]++;
+}
+
+/*****************************************************************************/
+/**
+ * @brief drop a holder from a buffer
+ * This function gives the buffer back to the frame pool when the last holder
+ * lets go
+ *
+ * @param	buffer is a pointer anywhere inside the buffer
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE void rxPoolRelease(u8 *buffer) {
+
+	int n = poolIndex(rxPool.pool, buffer);
+
+	if((n < 0) || (rxPool.refs[n] == 0)) {
+		rxPool.badRelease++;
+		return;
+	}
+
+	if(--rxPool.refs[n] == 0)
+		poolFree(rxPool.pool, buffer);
+}
+
+/*****************************************************************************/
+/**
+ * @brief number of free buffers
+ *
+ * @return	buffers free in the frame pool
+ *
+ * @note 	none
+ *
+******************************************************************************/
+unsigned int rxPoolFree(void) {
+
+	return poolAvailable(rxPool.pool);
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the receive pool
+ *
+ * @return	none
+ *
+ * @note 	the frame pool counters are shown by displayPools()
+ *
+******************************************************************************/
+COLD_CODE void displayRxPool(void) {
+
+	xil_printf("\nReceive buffers \t- %d free\n", poolAvailable(rxPool.pool));
+	if(rxPool.badRelease)
+		xil_printf("Bad releases \t\t- %d\n", rxPool.badRelease);
+}
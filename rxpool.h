@@ -0,0 +1,31 @@
+/*
+ * @file rxpool.h
+ */
+
+#ifndef RXPOOL_H_
+#define RXPOOL_H_
+
+#include "common.h"
+#include "pool.h"
+
+/**
+ * @struct rxpool_struct
+ * @brief reference counts over a frame pool
+ *
+ * a buffer goes back to its pool, and so back to the S2MM, when the last
+ * holder lets go of it
+ */
+typedef struct rxpool_type {
+	int				pool;								//!< frame pool the buffers come from
+	u8				refs[POOL_MAX_BUFFERS];				//!< holders of each buffer
+	unsigned int	badRelease;							//!< releases of a free buffer
+} rxpool_struct;
+
+void rxPoolInit(int);
+u8 *rxPoolGet(void);
+void rxPoolHold(u8 *);
+void rxPoolRelease(u8 *);
+unsigned int rxPoolFree(void);
+void displayRxPool(void);
+
+#endif /* RXPOOL_H_ */
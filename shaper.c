@@ -0,0 +1,165 @@
+/*
+ * @file shaper.c
+ * @brief token bucket rate shaper for the aurora transmit path
+ */
+
+#include "shaper.h"
+#include "timer.h"
+
+static shaper_struct shaper;
+
+/*****************************************************************************/
+/**
+ * @brief set up the shaper
+ * This function sets the sustained rate and burst size and fills the bucket
+ *
+ * @param	rate holds the sustained rate in bytes per second, 0 turns shaping off
+ * @param	burst holds the bucket size in bytes
+ *
+ * @return	success/failure
+ *
+ * @note 	a burst over SHAPER_MAX_BURST, which would overflow the signed
+ * 			fixed point tokens, or one that takes longer to fill than the 32
+ * 			bit timer takes to wrap is rejected and the shaper is left as it was
+ *
+******************************************************************************/
+int shaperInit(unsigned int rate, unsigned int burst) {
+
+	u64 fillTicks = 0;
+
+	if((rate != 0) && (burst != 0)) {
+		if(burst > SHAPER_MAX_BURST)
+			return XST_FAILURE;
+
+		fillTicks = ((u64)burst * TIMER_CLOCK_HZ) / rate;
+
+		if(fillTicks > 0xFFFFFFFF)
+			return XST_FAILURE;
+	}
+
+	shaper.enabled = (rate != 0) && (burst != 0);
+	shaper.rate = rate;
+	shaper.burst = burst;
+	shaper.framesDelayed = 0;
+	shaper.ticksWaiting = 0;
+
+	if(!shaper.enabled)
+		return XST_SUCCESS;
+
+	shaper.bytesPerTick = ((u64)rate << 32) / TIMER_CLOCK_HZ;
+	shaper.fillTicks = (unsigned int)fillTicks;
+	shaper.tokens = (s64)burst << 32;
+	shaper.lastTicks = timerGetTicks();
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief refill the bucket
+ * This function adds the tokens earned since the last refill.  Gaps longer
+ * than the fill time just fill the bucket, which also keeps the multiply
+ * from overflowing.
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE static void shaperRefill(void) {
+
+	unsigned int now, elapsed;
+
+	now = timerGetTicks();
+	elapsed = now - shaper.lastTicks;
+	shaper.lastTicks = now;
+
+	if(elapsed >= shaper.fillTicks) {
+		shaper.tokens = (s64)shaper.burst << 32;
+		return;
+	}
+
+	shaper.tokens += (s64)(elapsed * shaper.bytesPerTick);
+
+	if(shaper.tokens > ((s64)shaper.burst << 32))
+		shaper.tokens = (s64)shaper.burst << 32;
+}
+
+/*****************************************************************************/
+/**
+ * @brief check if a frame may be sent
+ * This function takes the tokens for a frame if they are available.  A frame
+ * larger than the bucket is let through once the bucket is full and leaves
+ * the bucket in debt, so the frames after it wait for the rate to catch up.
+ *
+ * @param	size holds the frame size in bytes
+ *
+ * @return	1-send now, 0-wait
+ *
+ * @note 	always 1 while shaping is off
+ *
+******************************************************************************/
+HOT_CODE int shaperAllow(unsigned int size) {
+
+	if(!shaper.enabled)
+		return 1;
+
+	shaperRefill();
+
+	if((shaper.tokens < ((s64)size << 32)) && (shaper.tokens < ((s64)shaper.burst << 32)))
+		return 0;
+
+	shaper.tokens -= (s64)size << 32;
+
+	return 1;
+}
+
+/*****************************************************************************/
+/**
+ * @brief wait until a frame may be sent
+ *
+ * @param	size holds the frame size in bytes
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE void shaperWait(unsigned int size) {
+
+	unsigned int start;
+
+	if(shaperAllow(size))
+		return;
+
+	start = timerGetTicks();
+	shaper.framesDelayed++;
+
+	while(!shaperAllow(size)) {
+		/* NOP */
+	}
+
+	shaper.ticksWaiting += timerGetTicks() - start;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the shaper settings and counters
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayShaper(void) {
+
+	if(!shaper.enabled) {
+		xil_printf("\nShaper off\n");
+		return;
+	}
+
+	xil_printf("\nRate \t\t\t- %d bytes/s\n", shaper.rate);
+	xil_printf("Burst \t\t\t- %d bytes\n", shaper.burst);
+	xil_printf("Frames delayed \t\t- %d\n", shaper.framesDelayed);
+	xil_printf("Time waiting \t\t- %d us\n", (unsigned int)(shaper.ticksWaiting / TIMER_TICKS_PER_US));
+}
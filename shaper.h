@@ -0,0 +1,36 @@
+/*
+ * @file shaper.h
+ */
+
+#ifndef SHAPER_H_
+#define SHAPER_H_
+
+#include "common.h"
+
+#define SHAPER_MAX_BURST	0x7FFFFFFF		// largest burst that fits the 32.32 signed tokens
+
+/**
+ * @struct shaper_struct
+ * @brief token bucket state
+ *
+ * tokens and bytesPerTick are fixed point with 32 fractional bits so the
+ * refill is a multiply, the only divide is when the rate is set
+ */
+typedef struct shaper_type {
+	unsigned int	enabled;			//!< 1-shaping
+	unsigned int	rate;				//!< sustained rate in bytes per second
+	unsigned int	burst;				//!< bucket size in bytes
+	u64				bytesPerTick;		//!< refill per timer tick
+	s64				tokens;				//!< bytes available, negative after an oversize frame
+	unsigned int	fillTicks;			//!< ticks to fill an empty bucket
+	unsigned int	lastTicks;			//!< timer at the last refill
+	unsigned int	framesDelayed;		//!< frames that had to wait for tokens
+	u64				ticksWaiting;		//!< total ticks spent waiting
+} shaper_struct;
+
+int shaperInit(unsigned int, unsigned int);
+int shaperAllow(unsigned int);
+void shaperWait(unsigned int);
+void displayShaper(void);
+
+#endif /* SHAPER_H_ */
@@ -5,10 +5,20 @@
  *      Author: Howard Graves
  */
 
+#include <string.h>
+
 #include "tests.h"
 #include "nwl_dma.h"
 #include "interrupt.h"
 #include "dma.h"
+#include "rtsp.h"
+#include "compress.h"
+#include "pack.h"
+#include "timer.h"
+#include "pool.h"
+#include "cache.h"
+#include "capture.h"
+#include "utilities.h"
 
 /*****************************************************************************/
 /**
@@ -33,12 +43,16 @@
  *
  * 		@return	success/failure
  *
- * 		@note 	none
+ * 		@note 	the AXI DMA buffers are pointed at the NWL buffers for the test
+ * 				and put back afterwards, so the data is compared here
  *
 ******************************************************************************/
-int PCIeAuroraLoopbackTest(params_struct *p) {
+COLD_CODE int PCIeAuroraLoopbackTest(params_struct *p) {
 
 	int status;
+	unsigned int i;
+	u8 *txBuffer = p->pTxBuffer;
+	u8 *rxBuffer = p->pRxBuffer;
 
 	p->pTxBuffer = (u8 *)p->dataSourceLocation;
 	p->pRxBuffer = (u8 *)p->dataDestinationLocation;
@@ -50,39 +64,63 @@ int PCIeAuroraLoopbackTest(params_struct *p) {
 
 	xil_printf("start PCIe transfer...\n");
 
-	while(!nwlInterruptFlag) {
-		/* NOP */
+	dmaWatchdogArm(DMA_WATCH_HOST);
+	if (dmaWait(DMA_WATCH_HOST, &nwlInterruptFlag) != XST_SUCCESS) {
+		xil_printf("no frame from the host\n");
+		p->pTxBuffer = txBuffer;
+		p->pRxBuffer = rxBuffer;
+		return XST_FAILURE;
 	}
 
 	nwlInterruptFlag = 0;
 
 	xil_printf("got NLW interrupt\n");
 
+	/*
+	 * the host wrote the frame, read it from DDR
+	 */
+	cacheInvalidate(p->pTxBuffer, RTSP_SYNC_SIZE + sizeof(strRtspFrameHeader));
+
 	p->testPacketSize = (p->ptr_RtspFrameHeader->dataSize + 4) * 4;
 
+	cacheInvalidate(p->pTxBuffer, p->testPacketSize);
+
 	xil_printf("packet size - %d\n",p->testPacketSize);
 
 	status = receiveDMA(p);
-	if (status != XST_SUCCESS) {
-		return XST_FAILURE;
+	if (status == XST_SUCCESS) {
+		xil_printf("receive set up\n");
+
+		status = sendDMA(p);
 	}
 
-	xil_printf("receive set up\n");
+	if (status == XST_SUCCESS) {
+		xil_printf("sent\n");
 
-	status = sendDMA(p);
-	if (status != XST_SUCCESS) {
-		return XST_FAILURE;
+		dmaWatchdogArm(DMA_WATCH_S2MM);
+		status = dmaWait(DMA_WATCH_S2MM, &RxDone);
 	}
 
-	xil_printf("sent\n");
-
-	while (!RxDone) {
-			/* NOP */
+	if (status != XST_SUCCESS) {
+		if (Error)
+			dmaRecoverWait(p->pAxiDma);
+	} else {
+		xil_printf("transfer complete\n");
+
+		dmaReceiveComplete(p->pAxiDma);
+
+		for (i = 0; i < p->testPacketSize; i++) {
+			if (p->pTxBuffer[i] != p->pRxBuffer[i]) {
+				status = XST_FAILURE;
+				break;
+			}
+		}
 	}
 
-	xil_printf("transfer complete\n");
+	p->pTxBuffer = txBuffer;
+	p->pRxBuffer = rxBuffer;
 
-	return XST_SUCCESS;
+	return (status == XST_SUCCESS) ? XST_SUCCESS : XST_FAILURE;
 }
 
 /*****************************************************************************/
@@ -97,7 +135,7 @@ int PCIeAuroraLoopbackTest(params_struct *p) {
  * 		@note 	none
  *
 ******************************************************************************/
-int AuroraloopbackTest(params_struct *p) {
+COLD_CODE int AuroraloopbackTest(params_struct *p) {
 
 	int status;
 	u8 value;
@@ -136,11 +174,11 @@ int AuroraloopbackTest(params_struct *p) {
 
 	XAxiDma_IntrEnable(p->pAxiDma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DEVICE_TO_DMA);
 
-	/* Flush the SrcBuffer before the DMA transfer, in case the Data Cache
-	 * is enabled
+	/*
+	 * push the pattern out to DDR and drop the cleared receive lines
 	 */
-	Xil_DCacheFlushRange((u32)p->pTxBuffer, DMA_TEST_VALUES);
-	Xil_DCacheFlushRange((u32)p->pRxBuffer, DMA_TEST_VALUES);
+	cacheFlush(p->pTxBuffer, DMA_TEST_VALUES);
+	cacheInvalidate(p->pRxBuffer, DMA_TEST_VALUES);
 
 	status = XAxiDma_SimpleTransfer(p->pAxiDma,(u32) p->pRxBuffer, DMA_TEST_VALUES, XAXIDMA_DEVICE_TO_DMA);
 	if (status != XST_SUCCESS) {
@@ -153,11 +191,11 @@ int AuroraloopbackTest(params_struct *p) {
 	}
 
 	/*
-	 * Wait TX done and RX done
+	 * Wait for the pattern to come back, the watchdog raises Error if it
+	 * never does
 	 */
-	while (!TxDone && !RxDone && !Error) {
-			/* NOP */
-	}
+	dmaWatchdogArm(DMA_WATCH_S2MM);
+	dmaWait(DMA_WATCH_S2MM, &RxDone);
 
 #ifdef __DEBUG
 #ifdef __DEBUG_VERBOSE
@@ -189,8 +227,12 @@ int AuroraloopbackTest(params_struct *p) {
 	tmpAddr = (unsigned int *)(dmaController->RegBase+0x58);val = *(tmpAddr); xil_printf("0x%08X\t0x%08X\n",tmpAddr,val);
 #endif
 
+		dmaRecoverWait(p->pAxiDma);
+		return XST_FAILURE;
 	}
 
+	cacheInvalidate(p->pRxBuffer, DMA_TEST_VALUES);
+
 	for(index=0; index<DMA_TEST_VALUES; index++) {
 		if(p->pTxBuffer[index] != p->pRxBuffer[index]) {
 			return XST_FAILURE;
@@ -199,3 +241,278 @@ int AuroraloopbackTest(params_struct *p) {
 
 	return XST_SUCCESS;
 }
+
+/*****************************************************************************/
+/**
+ * @brief delta compression benchmark
+ * This test builds a frame of random walk channels, compresses it in place,
+ * decompresses it into a second buffer and checks every sample comes back.
+ * It is run once for each step size so the speed can be seen across
+ * compression ratios.  The last column is the link rate below which
+ * compressing before sending beats sending raw.  A last pass packs the
+ * samples to 16 bits first and decodes them in the order a receiver does.
+ *
+ *    frame --> compressFrame --> decompressFrame --> compare
+ *    frame --> packFrame --> compressFrame --> decompressFrame --> unpackFrame --> compare
+ *
+ * 		@param	p points to parameters structure
+ *
+ * 		@return	success/failure
+ *
+ * 		@note 	uses the transmit buffer and two work buffers and adds to the
+ * 				compression and packing counters
+ *
+******************************************************************************/
+COLD_CODE int CompressionBenchmark(params_struct *p) {
+
+	static const unsigned int steps[] = {1, 8, 64, 1024, 16384, 1 << 20, 1 << 28};
+	strRtspFrameHeader *header = (strRtspFrameHeader *)(p->pTxBuffer + RTSP_SYNC_SIZE);
+	strRtspChannelHeader *channel;
+	unsigned int *samples;
+	unsigned int *check;
+	unsigned int rawSize, codedSize, start, compressUs, decompressUs;
+	unsigned int s, ch, i, seed, sample, bad, step, packed;
+	unsigned int wasEnabled = compressEnabled();
+	unsigned int wasWidth = packWidth();
+	unsigned int wasShift[PACK_MAX_CHANNELS];
+	int status = XST_SUCCESS;
+	u8 *decoded;
+	u8 *unpacked;
+
+	decoded = poolAlloc(POOL_WORK);
+	unpacked = poolAlloc(POOL_WORK);
+
+	if((decoded == NULL) || (unpacked == NULL)) {
+		if(decoded != NULL)
+			poolFree(POOL_WORK, decoded);
+		if(unpacked != NULL)
+			poolFree(POOL_WORK, unpacked);
+		return XST_FAILURE;
+	}
+
+	for(i = 0; i < PACK_MAX_CHANNELS; i++)
+		wasShift[i] = packShift(i);
+
+	compressEnable(1);
+	packSet(PACK_OFF, PACK_ALL_CHANNELS, 0);
+
+	xil_printf("\nstep\t\tratio\tcompress\tdecompress\tpays below\n");
+
+	for(s = 0; s <= sizeof(steps) / sizeof(steps[0]); s++) {
+
+		/*
+		 * the extra pass packs a step 1 walk, which fits 16 bits, so it
+		 * comes back exactly
+		 */
+		packed = (s == sizeof(steps) / sizeof(steps[0]));
+		step = packed ? 1 : steps[s];
+
+		if(packed)
+			packSet(PACK_16, PACK_ALL_CHANNELS, 0);
+
+		/*
+		 * build the frame
+		 */
+		header->headerID = 0;
+		header->shelfID = 0;
+		header->dataSize = BENCHMARK_CHANNELS * (RTSP_CHANNEL_HEADER_WORDS + BENCHMARK_SAMPLES);
+
+		seed = 1;
+		channel = (strRtspChannelHeader *)(header + 1);
+
+		for(ch = 0; ch < BENCHMARK_CHANNELS; ch++) {
+			for(i = 0; i < RTSP_CHANNEL_HEADER_WORDS; i++)
+				((unsigned int *)channel)[i] = 0;
+
+			channel->channelNumber = ch;
+			channel->channelSize = (RTSP_CHANNEL_HEADER_WORDS - 1) + BENCHMARK_SAMPLES;
+			channel->W = 1;
+			channel->N[0] = BENCHMARK_SAMPLES;
+
+			samples = (unsigned int *)channel + RTSP_CHANNEL_HEADER_WORDS;
+			sample = 0;
+			for(i = 0; i < BENCHMARK_SAMPLES; i++) {
+				seed = (seed * 1103515245) + 12345;
+				sample += (seed >> 1) % ((step * 2) + 1) - step;
+				samples[i] = sample;
+			}
+
+			channel = (strRtspChannelHeader *)(samples + BENCHMARK_SAMPLES);
+		}
+
+		rawSize = rtspFrameSize(header);
+
+		/*
+		 * time it
+		 */
+		start = timerGetTicks();
+		codedSize = packFrame(p->pTxBuffer, rawSize);
+		codedSize = compressFrame(p->pTxBuffer, codedSize);
+		compressUs = (timerGetTicks() - start) / TIMER_TICKS_PER_US;
+
+		start = timerGetTicks();
+		if(decompressFrame(p->pTxBuffer, decoded, poolBufferSize(POOL_WORK)) == 0) {
+			for(i = 0; i < codedSize / 4; i++)			// sent raw
+				((unsigned int *)decoded)[i] = ((unsigned int *)p->pTxBuffer)[i];
+		}
+		if(packed && (unpackFrame(decoded, unpacked, poolBufferSize(POOL_WORK)) == 0))
+			packed = 2;									// never packed, fails below
+		decompressUs = (timerGetTicks() - start) / TIMER_TICKS_PER_US;
+
+		/*
+		 * check it
+		 */
+		header = (strRtspFrameHeader *)((packed ? unpacked : decoded) + RTSP_SYNC_SIZE);
+		check = (unsigned int *)(header + 1);
+		bad = (packed == 2) ||
+				(header->dataSize != BENCHMARK_CHANNELS * (RTSP_CHANNEL_HEADER_WORDS + BENCHMARK_SAMPLES));
+
+		seed = 1;
+		for(ch = 0; (ch < BENCHMARK_CHANNELS) && !bad; ch++) {
+			check += RTSP_CHANNEL_HEADER_WORDS;
+			sample = 0;
+			for(i = 0; i < BENCHMARK_SAMPLES; i++) {
+				seed = (seed * 1103515245) + 12345;
+				sample += (seed >> 1) % ((step * 2) + 1) - step;
+				if(check[i] != sample)
+					bad++;
+			}
+			check += BENCHMARK_SAMPLES;
+		}
+
+		header = (strRtspFrameHeader *)(p->pTxBuffer + RTSP_SYNC_SIZE);
+
+		if(compressUs == 0)
+			compressUs = 1;
+		if(decompressUs == 0)
+			decompressUs = 1;
+
+		xil_printf("%d%s\t\t%d.%02d\t%d MB/s\t\t%d MB/s\t\t%d MB/s%s\n", step, packed ? " 16 bit" : "",
+				rawSize / codedSize, ((rawSize % codedSize) * 100) / codedSize,
+				rawSize / compressUs, rawSize / decompressUs,
+				(rawSize - codedSize) / compressUs,
+				bad ? "\tFAILED" : "");
+
+		if(bad)
+			status = XST_FAILURE;
+	}
+
+	compressEnable(wasEnabled);
+
+	for(i = 0; i < PACK_MAX_CHANNELS; i++)
+		packSet(wasWidth, i, wasShift[i]);
+
+	poolFree(POOL_WORK, decoded);
+	poolFree(POOL_WORK, unpacked);
+
+	return status;
+}
+
+/*****************************************************************************/
+/**
+ * @brief check the DMA error trigger
+ * This function arms the trigger on DMA errors with no post-trigger window,
+ * records a frame, raises an S2MM error as the interrupt handler would and
+ * lets the recovery clear it.  The ring must be frozen with the frame kept
+ * and a later frame must not be recorded.
+ *
+ * 		@param	p is a pointer to the parameters structure
+ *
+ * 		@return	success/failure
+ *
+ * 		@note 	the capture ring is cleared, the engine is reset and the
+ * 				error is counted in the recovery counters
+ *
+******************************************************************************/
+COLD_CODE int CaptureTriggerTest(params_struct *p) {
+
+	capture_trigger_struct config;
+	int status = XST_SUCCESS;
+
+	memset(&config, 0, sizeof(config));
+	config.sources = TRIGGER_DMA_ERROR;
+
+	triggerArm(&config);
+
+	captureFrame(p->pTxBuffer, DMA_TEST_VALUES);
+
+	dmaErrorRaise(XAXIDMA_DEVICE_TO_DMA, XAXIDMA_IRQ_ERROR_MASK);
+
+	if(dmaRecoverWait(p->pAxiDma) != XST_SUCCESS)
+		status = XST_FAILURE;
+
+	triggerPoll(p);													// Error is already cleared
+
+	captureFrame(p->pTxBuffer, DMA_TEST_VALUES);
+
+	if((triggerState() != TRIGGER_FROZEN) || captureEnabled() || (captureCount() != 1))
+		status = XST_FAILURE;
+
+	return status;
+}
+
+/*****************************************************************************/
+/**
+ * @brief round trip the bulk endian swap
+ * This function copies and swaps a pattern for every source and destination
+ * offset within a word, checks each word came out reversed and the bytes
+ * either side were not touched, swaps it back in place and compares it with
+ * the pattern.  It then times an in-place swap of a whole work buffer.
+ *
+ * 		@param	p is a pointer to the parameters structure
+ *
+ * 		@return	success/failure
+ *
+ * 		@note 	uses a work buffer
+ *
+******************************************************************************/
+COLD_CODE int EndianSwapTest(params_struct *p) {
+
+	u8 *work, *src, *dst;
+	unsigned int so, d, i, bad = 0, start, us;
+	unsigned int bytes = SWAP_TEST_WORDS * 4;
+
+	work = poolAlloc(POOL_WORK);
+	if(work == NULL)
+		return XST_FAILURE;
+
+	for(so = 0; so < 4; so++) {
+		for(d = 0; d < 4; d++) {
+			src = work + so;
+			dst = work + bytes + 8 + d;
+
+			for(i = 0; i < 3 * bytes; i++)
+				work[i] = (i < bytes + 4) ? (i * 7 + 1) : 0xEE;
+
+			swap_endian_copy(dst, src, SWAP_TEST_WORDS);
+
+			for(i = 0; i < bytes; i++)
+				if(dst[i] != src[(i & ~3) + 3 - (i & 3)])
+					bad++;
+
+			if((dst[-1] != 0xEE) || (dst[bytes] != 0xEE))
+				bad++;
+
+			swap_endian_buffer(dst, SWAP_TEST_WORDS);
+
+			if(memcmp(dst, src, bytes) || (dst[-1] != 0xEE) || (dst[bytes] != 0xEE))
+				bad++;
+		}
+	}
+
+	xil_printf("\nSwap round trip \t- %s\n", bad ? "FAILED" : "passed");
+
+	start = timerGetTicks();
+	swap_endian_buffer(work, poolBufferSize(POOL_WORK) / 4);
+	us = (timerGetTicks() - start) / TIMER_TICKS_PER_US;
+
+	if(us == 0)
+		us = 1;
+
+	xil_printf("Swap in place \t\t- %d bytes in %d us, %d MB/s\n", poolBufferSize(POOL_WORK), us,
+			poolBufferSize(POOL_WORK) / us);
+
+	poolFree(POOL_WORK, work);
+
+	return bad ? XST_FAILURE : XST_SUCCESS;
+}
@@ -10,7 +10,15 @@
 
 #include "common.h"
 
+#define BENCHMARK_CHANNELS	8			// channels in the compression test frame
+#define BENCHMARK_SAMPLES	4096		// samples per channel
+
+#define SWAP_TEST_WORDS		64			// words per endian swap case
+
 int PCIeAuroraLoopbackTest(params_struct *);
 int AuroraloopbackTest(params_struct *);
+int CompressionBenchmark(params_struct *);
+int CaptureTriggerTest(params_struct *);
+int EndianSwapTest(params_struct *);
 
 #endif /* TESTS_H_ */
@@ -0,0 +1,55 @@
+/*
+ * @file timer.c
+ * @brief AXI timer functions
+ */
+
+#include "timer.h"
+
+static XTmrCtr *pTimerInstance;
+
+/*****************************************************************************/
+/**
+ * @brief initialize the AXI timer
+ * This function starts counter 0 of the AXI timer as a free running up
+ * counter used for timestamps
+ *
+ * @param	timer holds a pointer to the timer instance
+ *
+ * @return	success/failure
+ *
+ * @note 	the counter wraps every 2^32 timer clocks
+ *
+******************************************************************************/
+int timerInit(XTmrCtr *timer) {
+
+	int status;
+
+	status = XTmrCtr_Initialize(timer, TIMER_DEV_ID);
+	if (status != XST_SUCCESS) {
+		xil_printf("Timer: Initialization failed %d\r\n", status);
+		return XST_FAILURE;
+	}
+
+	XTmrCtr_SetOptions(timer, 0, XTC_AUTO_RELOAD_OPTION);
+	XTmrCtr_SetResetValue(timer, 0, 0);
+	XTmrCtr_Reset(timer, 0);
+	XTmrCtr_Start(timer, 0);
+
+	pTimerInstance = timer;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief read the timer
+ *
+ * @return	current count of the free running counter
+ *
+ * @note 	use unsigned subtraction to measure intervals across a wrap
+ *
+******************************************************************************/
+HOT_CODE unsigned int timerGetTicks(void) {
+
+	return XTmrCtr_GetValue(pTimerInstance, 0);
+}
@@ -0,0 +1,15 @@
+/*
+ * @file timer.h
+ */
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include "common.h"
+
+#define TIMER_TICKS_PER_US	(TIMER_CLOCK_HZ / 1000000)
+
+int timerInit(XTmrCtr *);
+unsigned int timerGetTicks(void);
+
+#endif /* TIMER_H_ */
@@ -0,0 +1,199 @@
+/*
+ * @file txqueue.c
+ * @brief priority transmit queues for the aurora
+ */
+
+#include "txqueue.h"
+#include "route.h"
+
+static txq_struct txq[TXQ_CLASSES];
+static unsigned int txqMode;
+static unsigned int txqWeight;
+static unsigned int txqSmallFrame;
+static unsigned int txqHighRun;			// high priority sends since the last low send
+static int txqPicked;					// class returned by the last txqPeek()
+
+/*****************************************************************************/
+/**
+ * @brief set up the transmit queues
+ *
+ * @param	mode holds TXQ_STRICT or TXQ_WEIGHTED
+ * @param	weight holds the high priority sends allowed per low send
+ * @param	smallFrame holds the dataSize at or below which a frame is high
+ * 			priority, 0 leaves the choice to the routing table
+ *
+ * @return	none
+ *
+ * @note 	any queued frames are forgotten
+ *
+******************************************************************************/
+void txqInit(unsigned int mode, unsigned int weight, unsigned int smallFrame) {
+
+	int i;
+
+	for(i = 0; i < TXQ_CLASSES; i++) {
+		txq[i].head = 0;
+		txq[i].tail = 0;
+		txq[i].queued = 0;
+		txq[i].full = 0;
+		txq[i].maxDepth = 0;
+	}
+
+	txqMode = mode;
+	txqWeight = weight ? weight : 1;
+	txqSmallFrame = smallFrame;
+	txqHighRun = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief empty the transmit queues
+ *
+ * @return	none
+ *
+ * @note 	the counters are kept
+ *
+******************************************************************************/
+void txqFlush(void) {
+
+	int i;
+
+	for(i = 0; i < TXQ_CLASSES; i++)
+		txq[i].head = txq[i].tail;
+
+	txqHighRun = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief pick the priority class for a frame
+ *
+ * @param	header is a pointer to the RTSP frame header
+ * @param	dest holds the destination set from the routing table
+ *
+ * @return	TXQ_HIGH/TXQ_LOW
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE int txqClassify(strRtspFrameHeader *header, u8 dest) {
+
+	if(dest & ROUTE_PRIORITY)
+		return TXQ_HIGH;
+
+	if(txqSmallFrame && (header->dataSize <= txqSmallFrame))
+		return TXQ_HIGH;
+
+	return TXQ_LOW;
+}
+
+/*****************************************************************************/
+/**
+ * @brief queue a frame for transmit
+ *
+ * @param	class holds the priority class
+ * @param	frame is a pointer to the start of the frame
+ * @param	size holds the frame size in bytes
+ *
+ * @return	success/failure
+ *
+ * @note 	the frame must stay in place until it has been sent
+ *
+******************************************************************************/
+HOT_CODE int txqPut(int class, u8 *frame, unsigned int size) {
+
+	txq_struct *q = &txq[class];
+	unsigned int depth;
+
+	depth = q->tail - q->head;
+
+	if(depth == TXQ_DEPTH) {
+		q->full++;
+		return XST_FAILURE;
+	}
+
+	q->entries[q->tail & (TXQ_DEPTH - 1)].frame = frame;
+	q->entries[q->tail & (TXQ_DEPTH - 1)].size = size;
+	q->tail++;
+	q->queued++;
+
+	if(depth + 1 > q->maxDepth)
+		q->maxDepth = depth + 1;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ * @brief look at the next frame to send
+ * This function runs the scheduler.  Strict mode always prefers the high
+ * priority queue.  Weighted mode lets the high priority queue send weight
+ * frames and then gives the low priority queue a turn, so bulk data is
+ * never starved.
+ *
+ * @return	pointer to the queue entry, NULL if both queues are empty
+ *
+ * @note 	the entry stays queued until txqPop()
+ *
+******************************************************************************/
+HOT_CODE txq_entry_struct *txqPeek(void) {
+
+	int highReady = (txq[TXQ_HIGH].tail != txq[TXQ_HIGH].head);
+	int lowReady = (txq[TXQ_LOW].tail != txq[TXQ_LOW].head);
+
+	if(!highReady && !lowReady)
+		return NULL;
+
+	if(highReady && lowReady) {
+		if((txqMode == TXQ_WEIGHTED) && (txqHighRun >= txqWeight))
+			txqPicked = TXQ_LOW;
+		else
+			txqPicked = TXQ_HIGH;
+	} else
+		txqPicked = highReady ? TXQ_HIGH : TXQ_LOW;
+
+	return &txq[txqPicked].entries[txq[txqPicked].head & (TXQ_DEPTH - 1)];
+}
+
+/*****************************************************************************/
+/**
+ * @brief remove the frame returned by txqPeek()
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+HOT_CODE void txqPop(void) {
+
+	txq[txqPicked].head++;
+
+	if(txqPicked == TXQ_HIGH)
+		txqHighRun++;
+	else
+		txqHighRun = 0;
+}
+
+/*****************************************************************************/
+/**
+ * @brief display the transmit queues
+ *
+ * @return	none
+ *
+ * @note 	none
+ *
+******************************************************************************/
+COLD_CODE void displayTxq(void) {
+
+	int i;
+
+	xil_printf("\nScheduling \t\t- %s", (txqMode == TXQ_WEIGHTED) ? "weighted" : "strict");
+	if(txqMode == TXQ_WEIGHTED)
+		xil_printf(" (%d:1)", txqWeight);
+	xil_printf("\nSmall frame \t\t- %d\n", txqSmallFrame);
+
+	for(i = 0; i < TXQ_CLASSES; i++) {
+		xil_printf("%s queue \t\t- %d queued, %d refused, %d deepest\n", (i == TXQ_HIGH) ? "High" : "Low ",
+				txq[i].queued, txq[i].full, txq[i].maxDepth);
+	}
+}
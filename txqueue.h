@@ -0,0 +1,49 @@
+/*
+ * @file txqueue.h
+ */
+
+#ifndef TXQUEUE_H_
+#define TXQUEUE_H_
+
+#include "common.h"
+
+#define TXQ_HIGH		0			// latency critical frames
+#define TXQ_LOW			1			// bulk data
+#define TXQ_CLASSES		2
+
+#define TXQ_DEPTH		16			// must be a power of 2
+
+#define TXQ_STRICT		0			// high priority always goes first
+#define TXQ_WEIGHTED	1			// high priority gets weight sends per low send
+
+/**
+ * @struct txq_entry_struct
+ * @brief queued frame
+ */
+typedef struct txq_entry_type {
+	u8 *			frame;				//!< start of the frame (sync word)
+	unsigned int	size;				//!< frame size in bytes
+} txq_entry_struct;
+
+/**
+ * @struct txq_struct
+ * @brief transmit queue for one priority class
+ */
+typedef struct txq_type {
+	txq_entry_struct	entries[TXQ_DEPTH];
+	unsigned int		head;			//!< next entry to send
+	unsigned int		tail;			//!< next free entry
+	unsigned int		queued;			//!< frames queued
+	unsigned int		full;			//!< frames refused, queue full
+	unsigned int		maxDepth;		//!< deepest the queue has been
+} txq_struct;
+
+void txqInit(unsigned int, unsigned int, unsigned int);
+void txqFlush(void);
+int txqClassify(strRtspFrameHeader *, u8);
+int txqPut(int, u8 *, unsigned int);
+txq_entry_struct *txqPeek(void);
+void txqPop(void);
+void displayTxq(void);
+
+#endif /* TXQUEUE_H_ */
@@ -6,10 +6,64 @@
  *      Author: Howard Graves
  */
 
+#include <string.h>
+
 #include "utilities.h"
 #include "interrupt.h"
 #include "i2c.h"
 #include "dma.h"
+#include "timer.h"
+#include "cache.h"
+#include "pool.h"
+#include "rtsp.h"
+#include "txqueue.h"
+#include "crc.h"
+#include "reduce.h"
+#include "pack.h"
+#include "compress.h"
+
+/*
+ * placement symbols from lscript.ld
+ */
+extern char __hot_text_start[], __hot_text_end[], __text_end[];
+extern char __cold_text_start[], __cold_text_end[];
+extern char __ddr_data_start[], __ddr_data_end[];
+extern char __rodata_start[], __rodata_end[];
+extern char __data_start[], __data_end[];
+extern char __sdata_start[], __sbss_end[];
+extern char __bss_start[], __bss_end[];
+extern char _heap_start[], _heap_end[];
+extern char _stack_end[], _stack[];
+extern char __bram_high[], _end[];
+
+/**
+ * @struct placement_struct
+ * @brief hot path function checked by displayPlacement()
+ */
+typedef struct placement_type {
+	const char *	name;
+	void			(*function)(void);
+} placement_struct;
+
+#define PLACEMENT(f)	{ #f, (void (*)(void))f }
+
+DDR_DATA static const placement_struct hotPath[] = {
+	PLACEMENT(dmaS2MM_InterruptHandler),
+	PLACEMENT(dmaMM2S_InterruptHandler),
+	PLACEMENT(nwlDMA_InterruptHandler),
+	PLACEMENT(dmaTransfer),
+	PLACEMENT(dmaReceiveComplete),
+	PLACEMENT(cacheCommit),
+	PLACEMENT(runForwarding),
+	PLACEMENT(rtspValidate),
+	PLACEMENT(rtspDeliverFrame),
+	PLACEMENT(txqPut),
+	PLACEMENT(poolAlloc),
+	PLACEMENT(crc32),
+	PLACEMENT(reduceFrame),
+	PLACEMENT(packFrame),
+	PLACEMENT(compressFrame),
+};
 
 /*****************************************************************************/
 /**
@@ -69,6 +123,18 @@ unsigned int initControllers(params_struct * p) {
 		} else
 			xil_printf("done\n");
 
+		/*
+		 * Setup the timer
+		 */
+		xil_printf("setting up timer......");
+
+		status = timerInit(p->pTimer);
+		if (status != XST_SUCCESS) {
+			xil_printf("Timer: Init failure\n");
+			return XST_FAILURE;
+		} else
+			xil_printf("done\n");
+
 		/*
 		 * setup the si5324
 		 */
@@ -96,6 +162,43 @@ unsigned int initControllers(params_struct * p) {
 		return XST_SUCCESS;
 }
 
+/*
+ * moving bytes to a higher or lower address within a register, and so the
+ * direction a word that is not aligned is shifted in from its two aligned
+ * neighbours
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define BYTES_LATER(x, n)		((x) >> (n))
+#define BYTES_EARLIER(x, n)		((x) << (n))
+#else
+#define BYTES_LATER(x, n)		((x) << (n))
+#define BYTES_EARLIER(x, n)		((x) >> (n))
+#endif
+
+/*****************************************************************************/
+/**
+ * @brief swap the bytes of a word.
+ * This function uses the compiler builtin, which is the swapb instruction on
+ * a MicroBlaze with the reorder instructions and a shift sequence otherwise
+ *
+ * 		@param	data holds the word to be swapped
+ *
+ * 		@return	swapped data
+ *
+ * 		@note 	inlined into the buffer loops
+ *
+******************************************************************************/
+static inline unsigned int swap_word(unsigned int data) {
+
+#ifdef __GNUC__
+	return __builtin_bswap32(data);
+#else
+	data = ((data << 8) & 0xff00ff00) | ((data >> 8) & 0x00ff00ff);
+
+	return (data << 16) | (data >> 16);
+#endif
+}
+
 /*****************************************************************************/
 /**
  * @brief swap endian.
@@ -105,20 +208,154 @@ unsigned int initControllers(params_struct * p) {
  *
  * 		@return	swapped data
  *
- * 		@note 	none
+ * 		@note 	use swap_endian_buffer() for frames
  *
 ******************************************************************************/
 unsigned int swap_endian(unsigned int data) {
 
-	unsigned int b1,b2,b3,b4;
+	return swap_word(data);
+}
+
+/*****************************************************************************/
+/**
+ * @brief swap endian of a buffer that is not word aligned, in place.
+ * This function still only makes aligned word accesses.  Each word of the
+ * buffer is shifted together from the two aligned words it straddles,
+ * swapped, and split back, so the partial words at the head and the tail
+ * are read and written whole with the bytes outside the buffer kept.
+ *
+ * 		@param	buffer points to the first word
+ * 		@param	words holds the number of words to convert
+ *
+ * 		@return	none
+ *
+ * 		@note 	none
+ *
+******************************************************************************/
+static void swap_endian_unaligned(void *buffer, unsigned int words) {
+
+	unsigned int *p = (unsigned int *)((u32)buffer & ~3);
+	unsigned int shift = ((u32)buffer & 3) * 8;
+	unsigned int head = BYTES_EARLIER(0xFFFFFFFF, 32 - shift);	// bytes before the buffer
+	unsigned int cur, next, word, carry;
 
-	b1 = (data & 0x000000ff) << 24;
-	b2 = (data & 0x0000ff00) << 8;
-	b3 = (data & 0x00ff0000) >> 8;
-	b4 = (data & 0xff000000) >> 24;
+	if(words == 0)
+		return;
 
-	return (b1 | b2 | b3 | b4);
+	cur = *p;
+	carry = cur & head;
 
+	for(; words; words--, p++) {
+		next = p[1];
+
+		word = swap_word(BYTES_EARLIER(cur, shift) | BYTES_LATER(next, 32 - shift));
+
+		*p = carry | BYTES_LATER(word, shift);
+		carry = BYTES_EARLIER(word, 32 - shift);
+
+		cur = next;
+	}
+
+	*p = (cur & ~head) | carry;
+}
+
+/*****************************************************************************/
+/**
+ * @brief swap endian of a buffer in place.
+ * This function converts every word of a buffer.  Word aligned buffers are
+ * done eight words at a time, all the loads before the stores, so the loop
+ * runs at DDR speed rather than one call per word.  Other buffers are done a
+ * word at a time with aligned accesses.
+ *
+ * 		@param	buffer points to the first word
+ * 		@param	words holds the number of words to convert
+ *
+ * 		@return	none
+ *
+ * 		@note 	the buffer is converted in the data cache, flush it before
+ * 				handing it to a DMA
+ *
+******************************************************************************/
+void swap_endian_buffer(void *buffer, unsigned int words) {
+
+	unsigned int *p = (unsigned int *)buffer;
+	unsigned int w0, w1, w2, w3, w4, w5, w6, w7;
+
+	if((u32)buffer & 3) {
+		swap_endian_unaligned(buffer, words);
+		return;
+	}
+
+	for(; words >= 8; words -= 8, p += 8) {
+		w0 = p[0]; w1 = p[1]; w2 = p[2]; w3 = p[3];
+		w4 = p[4]; w5 = p[5]; w6 = p[6]; w7 = p[7];
+
+		p[0] = swap_word(w0); p[1] = swap_word(w1); p[2] = swap_word(w2); p[3] = swap_word(w3);
+		p[4] = swap_word(w4); p[5] = swap_word(w5); p[6] = swap_word(w6); p[7] = swap_word(w7);
+	}
+
+	for(; words; words--, p++)
+		*p = swap_word(*p);
+}
+
+/*****************************************************************************/
+/**
+ * @brief copy a buffer and swap endian on the way.
+ * This function does the copy and the conversion in one pass so each word
+ * crosses the bus once.  Word aligned buffers are done eight words at a time.
+ * A source that is not aligned is shifted together from aligned reads.  A
+ * destination that is not aligned is copied and then swapped in place.
+ *
+ * 		@param	dst points to the destination
+ * 		@param	src points to the source
+ * 		@param	words holds the number of words to copy
+ *
+ * 		@return	none
+ *
+ * 		@note 	the buffers must not overlap unless they are the same
+ *
+******************************************************************************/
+void swap_endian_copy(void *dst, const void *src, unsigned int words) {
+
+	unsigned int *d = (unsigned int *)dst;
+	const unsigned int *s = (const unsigned int *)src;
+	unsigned int w0, w1, w2, w3, w4, w5, w6, w7;
+	unsigned int shift, cur, next;
+
+	if(dst == src) {
+		swap_endian_buffer(dst, words);
+		return;
+	}
+
+	if((u32)dst & 3) {
+		memcpy(dst, src, words * 4);
+		swap_endian_unaligned(dst, words);
+		return;
+	}
+
+	if((u32)src & 3) {
+		shift = ((u32)src & 3) * 8;
+		s = (const unsigned int *)((u32)src & ~3);
+		cur = *s;
+
+		for(; words; words--) {
+			next = *++s;
+			*d++ = swap_word(BYTES_EARLIER(cur, shift) | BYTES_LATER(next, 32 - shift));
+			cur = next;
+		}
+		return;
+	}
+
+	for(; words >= 8; words -= 8, d += 8, s += 8) {
+		w0 = s[0]; w1 = s[1]; w2 = s[2]; w3 = s[3];
+		w4 = s[4]; w5 = s[5]; w6 = s[6]; w7 = s[7];
+
+		d[0] = swap_word(w0); d[1] = swap_word(w1); d[2] = swap_word(w2); d[3] = swap_word(w3);
+		d[4] = swap_word(w4); d[5] = swap_word(w5); d[6] = swap_word(w6); d[7] = swap_word(w7);
+	}
+
+	for(; words; words--)
+		*d++ = swap_word(*s++);
 }
 
 /*****************************************************************************/
@@ -194,7 +431,7 @@ void clear_ddr( unsigned int *startAddr, unsigned int *endAddr, unsigned int uVa
  * 		@note 	none
  *
 ******************************************************************************/
-void display_menu(params_struct *p) {
+COLD_CODE void display_menu(params_struct *p) {
 	xil_printf("\n******************************************************\n");
 	xil_printf("VC709 RTSP (Slave DMA) (V. %d)\n",p->software_version);
 	xil_printf("(Firmware - V.%d)\n",p->firmware_version);
@@ -204,8 +441,17 @@ void display_menu(params_struct *p) {
 	xil_printf("3 - Clear DDR\t\t\t7 - Read DMA Registers\n");
 	xil_printf("4 - Run PCI Loopback Test\t8 - Display Status\n");
 	xil_printf("L - Aurora Loopback test\t9 - Clear AXI Interrupt\n");
-	xil_printf("M - Display Menu\t\tW - Wait for Interrupt\n");
+	xil_printf("M - Display Menu\n");
 	xil_printf("S - Send Aurora Pkt\t\tR - Run RTSP\n");
+	xil_printf("F - Forward (Daisy Chain)\tI - Set Shelf ID\n");
+	xil_printf("T - Routing Table\t\tX - Filter Rules\n");
+	xil_printf("C - Capture Ring\t\tG - Capture Trigger\n");
+	xil_printf("P - Replay Frames\t\tH - Rate Shaper\n");
+	xil_printf("Q - Transmit Queues\t\tZ - Range Reduction\n");
+	xil_printf("K - Sample Packing\t\tD - Delta Compression\n");
+	xil_printf("Y - Frame CRC\t\t\tB - Code Placement\n");
+	xil_printf("O - DMA Polling\t\t\tW - DMA Watchdog\n");
+	xil_printf("N - NWL Status Queue\t\tU - Endian Swap\n");
 	xil_printf("******************************************************\n\n");
 
 	xil_printf("Region - ");
@@ -243,7 +489,7 @@ void display_menu(params_struct *p) {
  * 		@note 	none
  *
 ******************************************************************************/
-void display_registers(params_struct *p, unsigned int ch) {
+COLD_CODE void display_registers(params_struct *p, unsigned int ch) {
 
 	xil_printf("\nDMA Channel %d\n", ch);
 	xil_printf("(00) SRC_Q_PTR_LO - 0x%08x\n",p->pDmaChannelRegisters[ch]->SRC_Q_PTR_LO);
@@ -298,7 +544,7 @@ void display_registers(params_struct *p, unsigned int ch) {
   * 		@note 	none
   *
  ******************************************************************************/
- void display_all (params_struct *p) {
+COLD_CODE void display_all (params_struct *p) {
 
  	unsigned int tmp_intr_rx =  *p->ptr_GpioIntrRxReg;
  	unsigned int tmp_status_register = *p->ptr_GpioStatusReg;
@@ -348,3 +594,55 @@ void display_registers(params_struct *p, unsigned int ch) {
  	xil_printf("\n>");
 
  }
+
+/*****************************************************************************/
+/**
+ * @brief display where the code was linked
+ * This function shows the size of each section as linked, how much of the
+ * local BRAM is used and checks that each hot path function is in BRAM
+ *
+ * 		@return	none
+ *
+ * 		@note 	a function reported in DDR has lost its HOT_CODE
+ *
+******************************************************************************/
+COLD_CODE void displayPlacement(void) {
+
+	unsigned int i, address, misplaced = 0;
+
+	xil_printf("\nHot text \t\t- 0x%08X - 0x%08X, %d bytes\n", (u32)__hot_text_start,
+			(u32)__hot_text_end, __hot_text_end - __hot_text_start);
+	xil_printf("Other text \t\t- 0x%08X - 0x%08X, %d bytes\n", (u32)__hot_text_end,
+			(u32)__text_end, __text_end - __hot_text_end);
+	xil_printf("Read only data \t\t- 0x%08X - 0x%08X, %d bytes\n", (u32)__rodata_start,
+			(u32)__rodata_end, __rodata_end - __rodata_start);
+	xil_printf("Data \t\t\t- 0x%08X - 0x%08X, %d bytes\n", (u32)__data_start,
+			(u32)__data_end, __data_end - __data_start);
+	xil_printf("Small data and bss \t- 0x%08X - 0x%08X, %d bytes\n", (u32)__sdata_start,
+			(u32)__sbss_end, __sbss_end - __sdata_start);
+	xil_printf("Bss \t\t\t- 0x%08X - 0x%08X, %d bytes\n", (u32)__bss_start,
+			(u32)__bss_end, __bss_end - __bss_start);
+	xil_printf("Heap \t\t\t- 0x%08X - 0x%08X, %d bytes\n", (u32)_heap_start,
+			(u32)_heap_end, _heap_end - _heap_start);
+	xil_printf("Stack \t\t\t- 0x%08X - 0x%08X, %d bytes\n", (u32)_stack_end,
+			(u32)_stack, _stack - _stack_end);
+	xil_printf("BRAM used \t\t- %d of %d bytes\n\n", (u32)_end, (u32)__bram_high);
+	xil_printf("Cold text \t\t- 0x%08X - 0x%08X, %d bytes\n", (u32)__cold_text_start,
+			(u32)__cold_text_end, __cold_text_end - __cold_text_start);
+	xil_printf("DDR tables \t\t- 0x%08X - 0x%08X, %d bytes\n\n", (u32)__ddr_data_start,
+			(u32)__ddr_data_end, __ddr_data_end - __ddr_data_start);
+
+	for(i = 0; i < sizeof(hotPath) / sizeof(hotPath[0]); i++) {
+		address = (u32)hotPath[i].function;
+
+		if(address < (u32)__bram_high)
+			xil_printf("0x%08X\tBRAM\t%s\n", address, hotPath[i].name);
+		else {
+			xil_printf("0x%08X\tDDR\t%s\n", address, hotPath[i].name);
+			misplaced++;
+		}
+	}
+
+	if(misplaced)
+		xil_printf("\n%d hot path functions are not in BRAM\n", misplaced);
+}
@@ -9,9 +9,12 @@
 
 unsigned int initControllers(params_struct *);
 unsigned int swap_endian(unsigned int);
+void swap_endian_buffer(void *, unsigned int);
+void swap_endian_copy(void *, const void *, unsigned int);
 int boundary_check(unsigned long);
 void display_menu(params_struct *);
 void clear_ddr(unsigned int *, unsigned int *, unsigned int, unsigned char);
 void display_registers(params_struct *, unsigned int);
 void write_register(unsigned int *,unsigned int);
 void display_all(params_struct *);
+void displayPlacement(void);
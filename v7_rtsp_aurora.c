@@ -28,6 +28,20 @@
 #include "interrupt.h"
 #include "nwl_dma.h"
 #include "tests.h"
+#include "rtsp.h"
+#include "route.h"
+#include "filter.h"
+#include "capture.h"
+#include "replay.h"
+#include "shaper.h"
+#include "txqueue.h"
+#include "reduce.h"
+#include "pack.h"
+#include "compress.h"
+#include "crc.h"
+#include "dma.h"
+#include "pool.h"
+#include "cache.h"
 
 //GPIO
 //0  	LED#6 on VC709
@@ -35,6 +49,15 @@
 //5-7	not used
 //8		DMA slave region (0-PCIe, 1-AXI)
 
+/*
+ * variables to hold GPIO contents, shared by the start up and the menu
+ */
+static unsigned int s_sideband_register = 0x00000202;
+static unsigned int s_status_register = 0;
+static unsigned int gpioRegister = 0;
+
+static void runMenu(params_struct *);
+
 /*****************************************************************************/
 /**
 * @brief v7_rtsp_aurora main routine.
@@ -55,67 +78,69 @@ int main()
 	unsigned int *hwGPIO;
     unsigned int *fwVersionReg;
 
-    unsigned int channel;
-
-    unsigned char *uc_writeAddress;
-    unsigned short *us_writeAddress;
-    unsigned int *ul_writeAddress;
-
-    /*
-     * variables to hold GPIO contents
-     */
-    unsigned int s_sideband_register = 0x00000202;
-    unsigned int s_status_register = 0;
-    unsigned int s_intr_rx = 0;
-    unsigned int gpioRegister = 0;
-
     static XIic IicInstance;	/* The instance of the IIC device. */
 	static XAxiDma AxiDma;		/* Instance of the XAxiDma */
 	static XIntc InterruptController;
+	static XTmrCtr Timer;
 
 	hwGPIO = (unsigned int *)XPAR_GPIO_0_BASEADDR;
     fwVersionReg = (unsigned int *)XPAR_VERSION_REGISTER_0_S00_AXI_BASEADDR;
 
-	unsigned int i, status, tmpAddr, testFailed;
-	unsigned long startingAddress, wordsToRead, wordToWrite;
-	unsigned char err, writeBytes;
-
-	unsigned int startAddr, endAddr, clearValue;
-
-	char readBuffer[8], done, tempRead, display;
-	char ok2read = 0;
-	char readSize;
-
-	unsigned int k;
-
-	unsigned int frameCount;
-	unsigned char auroraFrameCount=0;
+	unsigned int i, status;
 
 	pParams->software_version = SW_VERSION;
 	pParams->firmware_version = *fwVersionReg;
 	pParams->pAxiDma = &AxiDma;
+	pParams->pTimer = &Timer;
 	pParams->pIicInstance = &IicInstance;
 	pParams->pInterruptController = &InterruptController;
 	pParams->pUART = (uart_struct *)XPAR_UARTLITE_0_BASEADDR;
-	pParams->dataSourceLocation = 		0x80000000;
-	pParams->dataDestinationLocation = 	0x90000000;
 	pParams->testPacketSize = 4096;
+	pParams->shelfID = RTSP_SHELF_NONE;
+	pParams->headerID = RTSP_HEADER_ID_ANY;
     pParams->nwlDmaSlaveRegisterBase = (unsigned int *)XPAR_M07_AXI_BASEADDR;
 	pParams->pDmaChannelRegisters[0] = 	(dma_reg_struct *) (XPAR_M07_AXI_BASEADDR + 0x40);
 	pParams->pDmaChannelRegisters[1] = 	(dma_reg_struct *) (XPAR_M07_AXI_BASEADDR + 0x80);
 	pParams->pDmaChannelRegisters[2] = 	(dma_reg_struct *) (XPAR_M07_AXI_BASEADDR + 0xC0);
-	pParams->pRxBuffer = (u8 *)DMA_RX_BUFFER_BASE;
-	pParams->pTxBuffer = (u8 *)DMA_TX_BUFFER_BASE;
     pParams->ptr_sSidebandRegister = (struct strSSideband *)&s_sideband_register;
     pParams->ptr_sStatusRegister = (struct strSStatus *)&s_status_register;
     pParams->ptr_GpioSidebandReg = (unsigned int *)XPAR_S_SIDEBAND_REG_BASEADDR;
     pParams->ptr_GpioIntrRxReg = (unsigned int *)XPAR_S_INTR_RX_REG_BASEADDR;
     pParams->ptr_GpioStatusReg = (unsigned int *)XPAR_AXI_STATUS_REG_BASEADDR;
     pParams->ptr_GPIORegister = (gpio_reg_struct *)&gpioRegister;
-    pParams->ptr_RtspFrameHeader = (strRtspFrameHeader *)0x80000004;
 
 	init_platform();
 
+	/*
+	 * carve DDR into frame buffer pools, the first host buffer is where the
+	 * host writes frames
+	 */
+	status = poolInit(POOL_HOST, "Host", HOST_POOL_BASE, HOST_POOL_SIZE, HOST_BUFFER_SIZE);
+	if (status == XST_SUCCESS)
+		status = poolInit(POOL_DMA, "DMA", DMA_POOL_BASE, DMA_POOL_SIZE, DMA_BOUNCE_SIZE);
+	if (status == XST_SUCCESS)
+		status = poolInit(POOL_WORK, "Work", WORK_POOL_BASE, WORK_POOL_SIZE, WORK_BUFFER_SIZE);
+	if (status == XST_SUCCESS)
+		status = poolInit(POOL_FORWARD, "Forward", FORWARD_POOL_BASE, FORWARD_POOL_SIZE, FORWARD_SLOT_SIZE);
+	if (status != XST_SUCCESS) {
+
+		xil_printf( "Failed to set up the buffer pools\r\n");
+		return XST_FAILURE;
+	}
+
+	pParams->dataSourceLocation = (unsigned int)poolAlloc(POOL_HOST);
+	pParams->dataDestinationLocation = (unsigned int)poolAlloc(POOL_HOST);
+	pParams->pTxBuffer = poolAlloc(POOL_DMA);
+	pParams->pRxBuffer = poolAlloc(POOL_DMA);
+
+	if ((pParams->dataSourceLocation == 0) || (pParams->dataDestinationLocation == 0) ||
+			(pParams->pTxBuffer == NULL) || (pParams->pRxBuffer == NULL)) {
+
+		xil_printf( "Failed to allocate the frame buffers\r\n");
+		return XST_FAILURE;
+	}
+	pParams->ptr_RtspFrameHeader = (strRtspFrameHeader *)(pParams->dataSourceLocation + RTSP_SYNC_SIZE);
+
 	/* set up controllers */
 	status = initControllers(pParams);
 	if (status != XST_SUCCESS) {
@@ -124,11 +149,19 @@ int main()
 		return XST_FAILURE;
 	}
 
+	routeInit(ROUTE_AURORA);
+	filterInit();
+	captureInit();
+	shaperInit(0, 0);
+	txqInit(TXQ_STRICT, 1, 0);
+	reduceInit();
+	packInit();
+	compressInit();
+	crcInit();
+
 	// set default slave register values
     write_register(pParams->ptr_GpioSidebandReg, s_sideband_register);
 
-	display = 1;
-
 	printf("reseting aurora........");
 	pParams->ptr_GPIORegister->auroraResetn = 1;		// release aurora_reset
 	*hwGPIO = gpioRegister;
@@ -139,6 +172,69 @@ int main()
 
 	for(i=0;i<10000000;i++);
 
+	runMenu(pParams);
+
+	return 0;
+
+} // end of main
+
+/*****************************************************************************/
+/**
+* @brief console menu
+* This function runs the UART menu for good once the board is set up.  It is
+* kept in DDR with the rest of the console code, out of the way of the hot
+* path in BRAM.
+*
+* @param	pParams is a pointer to the parameters structure
+*
+* @return	none, never returns
+*
+* @note		main() stays live under it, so the parameters it set up stay valid
+*
+******************************************************************************/
+COLD_CODE static void runMenu(params_struct *pParams)
+{
+
+    unsigned int channel;
+
+    unsigned char *uc_writeAddress;
+    unsigned short *us_writeAddress;
+    unsigned int *ul_writeAddress;
+
+    unsigned int s_intr_rx = 0;
+
+	unsigned int i, status, tmpAddr, testFailed;
+	unsigned long startingAddress, wordsToRead, wordToWrite;
+	unsigned char err, writeBytes;
+
+	unsigned int startAddr, endAddr, clearValue, nwlErrors, txPending;
+	int recoveryState;
+
+	char readBuffer[8], done, tempRead, display;
+	char ok2read = 0;
+	char readSize;
+
+	unsigned int k;
+
+	unsigned int frameCount;
+	unsigned char auroraFrameCount=0;
+
+	unsigned int shelf;
+	u8 dest;
+	filter_rule_struct rule;
+	capture_trigger_struct trigger;
+	replay_struct replay;
+	u8 *txBuffer;
+
+	unsigned int rate, burst;					// rate shaper
+	unsigned int weight, smallFrame;			// transmit queues
+	unsigned int range, factor;					// range reduction
+	unsigned int width, packedChannel, shift;	// sample packing
+	unsigned int pollBytes, pollBudgetUs;		// polled DMA completion
+	unsigned int deadlineUs;					// DMA watchdog
+
+	display = 1;
+
 	display_menu(pParams);
 
 	status = 0;
@@ -303,27 +399,16 @@ int main()
 						xil_printf("Running DMA/Aurora test.....\n");
 
 						/*
-						 * clear aurora rx and tx buffers
+						 * clear the NWL source and destination buffers the test runs in
 						 */
-						for(i=0;i<AURORA_BUFFER_SIZE;i++) {
-							pParams->pRxBuffer[i] = 0x00;
-							pParams->pTxBuffer[i] = 0x00;
-						}
+						clear_ddr((unsigned int *)pParams->dataSourceLocation, (unsigned int *)(pParams->dataSourceLocation + AURORA_BUFFER_SIZE - 4), 0x00, 1);
+						clear_ddr((unsigned int *)pParams->dataDestinationLocation, (unsigned int *)(pParams->dataDestinationLocation + AURORA_BUFFER_SIZE - 4), 0x00, 1);
+						cacheFlush((u8 *)pParams->dataSourceLocation, AURORA_BUFFER_SIZE);		// before the host writes it
 
 						xil_printf("buffers cleared\n");
 
 						status = PCIeAuroraLoopbackTest(pParams);
-						if (status != XST_SUCCESS) {
-							xil_printf("DMA: Initialization failed %d\r\n", status);
-						}
-
-						testFailed=0;
-						for(i=0;i<pParams->testPacketSize;i++) {
-							if(pParams->pTxBuffer[i] != pParams->pRxBuffer[i]){
-								testFailed=1;
-								break;
-							}
-						}
+						testFailed = (status != XST_SUCCESS);
 
 						if(testFailed)
 							xil_printf("loopback failed\n>");
@@ -536,6 +621,20 @@ int main()
 
 					display_all(pParams);
 
+					displayDmaBounce();
+
+					displayDmaPoll();
+
+					displayDmaRecovery();
+
+					displayDmaWatchdog();
+
+					displayNwlReaper();
+
+					displayPools();
+
+					displayCache();
+
 					break;
 
 				case '9':
@@ -596,31 +695,100 @@ int main()
 					/*
 					 * enable interrupts
 					 */
-					enableInterrupts(pParams, NWL_INTERRUPT || AXIDMA_TX_INTERRUPT);
+					enableInterrupts(pParams, NWL_INTERRUPT | AXIDMA_TX_INTERRUPT);
 
 					frameCount=0;
+					txPending = 0;
+					TxDone = 0;
 
 
-					/* Load first location of memory with a header */
-					pParams->pTxBuffer = (u8 *)0x80000000;
-					pParams->pTxBuffer[0] = 0xAA;
-					pParams->pTxBuffer[1] = 0xBB;
-					pParams->pTxBuffer[2] = 0xEB;
-					pParams->pTxBuffer[3] = 0x90;
+					/* Load first location of memory with a header, once, it is left alone after that */
+					txBuffer = pParams->pTxBuffer;
+					pParams->pTxBuffer = (u8 *)pParams->dataSourceLocation;
+					rtspSupplySync(pParams->pTxBuffer);
 
 					xil_printf("Running (Press any key to quit)\n");
 
 					while(!(pParams->pUART->status & 0x00000001)) {			// check for key press
 
+						/*
+						 * hold the host frames off while a DMA error is reset
+						 */
+						if(Error) {
+							triggerPoll(pParams);
+
+							recoveryState = dmaRecover(pParams->pAxiDma);
+							if(recoveryState == DMA_RECOVERY_FAILED) {
+								xil_printf("DMA ERROR - engine did not recover\n");
+								break;
+							}
+
+							if(recoveryState == DMA_RECOVERY_READY)
+								txPending = 0;						// lost in the reset
+							continue;
+						}
+
+						/*
+						 * the last frame is still going out, leave the next one
+						 * until it has gone or the watchdog gives up on it
+						 */
+						if(txPending) {
+							if(!TxDone) {
+								if(dmaWatchdogExpired(DMA_WATCH_MM2S))
+									Error = 1;						// the recovery reset cancels it
+								continue;
+							}
+
+							dmaWatchdogDisarm(DMA_WATCH_MM2S);
+							txPending = 0;
+						}
+
 						if(nwlInterruptFlag) {
 
-							pParams->testPacketSize = ((pParams->ptr_RtspFrameHeader->dataSize + 4) * 4) + 4;
+							triggerPoll(pParams);
+
+							/*
+							 * retire the host descriptors that have finished
+							 */
+							if(nwlReap(pParams, 0, &nwlErrors) && nwlErrors)
+								xil_printf("NWL status error 0x%X\n", nwlErrors);
+
+							/*
+							 * the host wrote the frame behind the cache, read the
+							 * header from DDR and then the rest once it is sized
+							 */
+							cacheInvalidate(pParams->pTxBuffer, RTSP_SYNC_SIZE + sizeof(strRtspFrameHeader));
+
+							/*
+							 * reject a bad header before its dataSize sizes a transfer
+							 */
+							if(rtspValidate(pParams, pParams->pTxBuffer, RTSP_MAX_FRAME_SIZE) != RTSP_VALID) {
+								pParams->testPacketSize = 0;
+								dest = ROUTE_DROP;
+							} else {
+								pParams->testPacketSize = rtspFrameSize(pParams->ptr_RtspFrameHeader);
+								cacheInvalidate(pParams->pTxBuffer, pParams->testPacketSize);
+								dest = rtspRoute(pParams, pParams->ptr_RtspFrameHeader);
+							}
 
 							xil_printf("packet size - %d\n",pParams->testPacketSize);
 
-							status = XAxiDma_SimpleTransfer(pParams->pAxiDma, (u32) pParams->pTxBuffer, pParams->testPacketSize, XAXIDMA_DMA_TO_DEVICE);
-							if (status != XST_SUCCESS) {
-								return XST_FAILURE;
+							rtspDeliverFrame(pParams, dest, pParams->pTxBuffer, pParams->testPacketSize);
+
+							if(dest & ROUTE_AURORA) {
+								pParams->testPacketSize = reduceFrame(pParams->pTxBuffer, pParams->testPacketSize);
+								pParams->testPacketSize = packFrame(pParams->pTxBuffer, pParams->testPacketSize);
+								pParams->testPacketSize = compressFrame(pParams->pTxBuffer, pParams->testPacketSize);
+								pParams->testPacketSize = crcAppend(pParams->pTxBuffer, pParams->testPacketSize);
+
+								TxDone = 0;
+
+								status = rtspTransmit(pParams, pParams->pTxBuffer, pParams->testPacketSize);
+								if (status == XST_SUCCESS) {
+									dmaWatchdogArm(DMA_WATCH_MM2S);
+									txPending = 1;
+								} else if (!Error)
+									xil_printf("transmit failed, frame dropped\n");
 							}
 
 							if((frameCount % 100) == 0)
@@ -632,11 +800,17 @@ int main()
 
 					}
 
+					/*
+					 * a transmit is still outstanding if we quit while waiting, reset the engine
+					 */
+					if((txPending && !TxDone) || Error)
+						dmaRecoverWait(pParams->pAxiDma);
+
 					xil_printf("\n%d frames processed\n\n>",frameCount);
 
 					disableInterrupts(pParams, ALL_INTERRUPTS);
 
-					pParams->pTxBuffer = (u8 *)DMA_TX_BUFFER_BASE;
+					pParams->pTxBuffer = txBuffer;
 
 					break;
 
@@ -652,6 +826,13 @@ int main()
 						xil_printf("\nNumber of bytes to send - ");
 						pParams->testPacketSize = get_u32_value(pParams, display, (int) 10);			// get starting address from uart
 
+						if(pParams->testPacketSize > poolBufferSize(POOL_DMA)) {
+							pParams->testPacketSize = poolBufferSize(POOL_DMA);
+							xil_printf("\nlimited to the %d byte transmit buffer", pParams->testPacketSize);
+						}
+						if(pParams->testPacketSize < RTSP_SYNC_SIZE)				// the header below is written anyway
+							pParams->testPacketSize = RTSP_SYNC_SIZE;
+
 						clearInterruptFlags();
 
 						XAxiDma_IntrEnable(pParams->pAxiDma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DMA_TO_DEVICE);
@@ -666,6 +847,8 @@ int main()
 						pParams->pTxBuffer[2]=auroraFrameCount;
 						pParams->pTxBuffer[3]=auroraFrameCount;
 
+						cacheDirty(pParams->pTxBuffer, pParams->testPacketSize);
+
 						auroraFrameCount++;
 
 //						for(i=0;i<pParams->testPacketSize;i++) {
@@ -676,17 +859,550 @@ int main()
 //						}
 //						xil_printf("\n");
 
-						status = XAxiDma_SimpleTransfer(pParams->pAxiDma, (u32) pParams->pTxBuffer, pParams->testPacketSize, XAXIDMA_DMA_TO_DEVICE);
-						if (status != XST_SUCCESS) {
-							return XST_FAILURE;
+						status = dmaTransferWait(pParams->pAxiDma, pParams->pTxBuffer, pParams->testPacketSize, XAXIDMA_DMA_TO_DEVICE);
+
+						if (Error) {
+							xil_printf("DMA ERROR - ");
+							xil_printf(dmaRecoverWait(pParams->pAxiDma) == XST_SUCCESS ? "engine reset\n" : "engine did not recover\n");
 						}
 
 						disableInterrupts(pParams, ALL_INTERRUPTS);
-						xil_printf("Sent %d bytes\n\n>",pParams->testPacketSize);
+
+						if (status != XST_SUCCESS)
+							xil_printf("Send failed\n\n>");
+						else
+							xil_printf("Sent %d bytes\n\n>",pParams->testPacketSize);
+					} else xil_printf("Aurora channel not UP\n>");
+
+					break;
+
+				case 'F':										// daisy-chain forwarding
+				case 'f':
+					s_status_register = *pParams->ptr_GpioStatusReg;
+
+					if(pParams->ptr_sStatusRegister->channel_up == 1) {
+						status = runForwarding(pParams);
+						if (status != XST_SUCCESS)
+							xil_printf("Forwarding FAILED\n");
+						xil_printf("\n>");
 					} else xil_printf("Aurora channel not UP\n>");
 
 					break;
 
+				case 'I':										// set shelf and header ID
+				case 'i':
+					xil_printf("\nShelf ID (FFFFFFFF - none) - 0x");
+
+					pParams->shelfID = get_u32_value(pParams, display, (int) 16);
+
+					xil_printf("\nHeader ID (FFFFFFFF - any) - 0x");
+
+					pParams->headerID = get_u32_value(pParams, display, (int) 16);
+
+					displayForwardStats(pParams);
+					xil_printf("\n>");
+
+					break;
+
+				case 'T':										// routing table
+				case 't':
+					xil_printf("\nRouting (E-enable, D-disable, S-set entry, C-clear) - ");
+
+					while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+					tempRead = pParams->pUART->rx;						// get character
+
+					xil_printf("%c\n",tempRead);
+
+					switch (tempRead) {
+						case 'E' :
+						case 'e' :
+							routeEnable(1);
+							break;
+						case 'D' :
+						case 'd' :
+							routeEnable(0);
+							break;
+						case 'S' :
+						case 's' :
+							xil_printf("Shelf ID - ");
+							shelf = get_u32_value(pParams, display, (int) 10);
+
+							xil_printf("\nChannel - ");
+							channel = get_u32_value(pParams, display, (int) 10);
+
+							xil_printf("\nDestinations (1-aurora, 2-host, 4-capture, 8-priority, 0-drop) - ");
+							dest = get_u32_value(pParams, display, (int) 16);
+
+							if(routeSet(shelf, channel, dest) != XST_SUCCESS)
+								xil_printf("\nERROR - Shelf or channel out of range\n");
+							break;
+						case 'C' :
+						case 'c' :
+							routeInit(ROUTE_AURORA);
+							break;
+						default:
+							break;
+					}
+
+					displayRouteTable();
+					xil_printf("\n>");
+
+					break;
+
+				case 'X':										// filter rules
+				case 'x':
+					xil_printf("\nFilter (A-add rule, C-clear) - ");
+
+					while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+					tempRead = pParams->pUART->rx;						// get character
+
+					xil_printf("%c\n",tempRead);
+
+					switch (tempRead) {
+						case 'A' :
+						case 'a' :
+							xil_printf("Shelf ID low - ");
+							rule.shelfLow = get_u32_value(pParams, display, (int) 10);
+
+							xil_printf("\nShelf ID high - ");
+							rule.shelfHigh = get_u32_value(pParams, display, (int) 10);
+
+							xil_printf("\nChannel mask - 0x");
+							rule.channelMask = get_u32_value(pParams, display, (int) 16);
+
+							xil_printf("\nData size low - ");
+							rule.sizeLow = get_u32_value(pParams, display, (int) 10);
+
+							xil_printf("\nData size high - ");
+							rule.sizeHigh = get_u32_value(pParams, display, (int) 10);
+
+							if(filterAddRule(&rule) != XST_SUCCESS)
+								xil_printf("\nERROR - Filter full\n");
+							break;
+						case 'C' :
+						case 'c' :
+							filterInit();
+							break;
+						default:
+							break;
+					}
+
+					displayFilterRules();
+					xil_printf("\n>");
+
+					break;
+
+				case 'C':										// capture ring
+				case 'c':
+					xil_printf("\nCapture (E-enable, D-disable, C-clear, I-index) - ");
+
+					while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+					tempRead = pParams->pUART->rx;						// get character
+
+					xil_printf("%c\n",tempRead);
+
+					wordsToRead = 0;
+
+					switch (tempRead) {
+						case 'E' :
+						case 'e' :
+							captureEnable(1);
+							break;
+						case 'D' :
+						case 'd' :
+							captureEnable(0);
+							break;
+						case 'C' :
+						case 'c' :
+							captureInit();
+							break;
+						case 'I' :
+						case 'i' :
+							xil_printf("Entries to display - ");
+							wordsToRead = get_u32_value(pParams, display, (int) 10);
+							xil_printf("\n");
+							break;
+						default:
+							break;
+					}
+
+					displayCapture(wordsToRead);
+					xil_printf("\n>");
+
+					break;
+
+				case 'G':										// capture trigger
+				case 'g':
+					xil_printf("\nTrigger (A-arm, D-disarm, T-test) - ");
+
+					while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+					tempRead = pParams->pUART->rx;						// get character
+
+					xil_printf("%c\n",tempRead);
+
+					switch (tempRead) {
+						case 'A' :
+						case 'a' :
+							xil_printf("Sources (1-link error, 2-DMA error, 4-sequence gap, 8-match) - 0x");
+							trigger.sources = get_u32_value(pParams, display, (int) 16);
+
+							xil_printf("\nPre-trigger frames - ");
+							trigger.preFrames = get_u32_value(pParams, display, (int) 10);
+
+							xil_printf("\nPost-trigger frames - ");
+							trigger.postFrames = get_u32_value(pParams, display, (int) 10);
+
+							if(trigger.sources & TRIGGER_SEQUENCE_GAP) {
+								xil_printf("\nSequence word - ");
+								trigger.sequenceWord = get_u32_value(pParams, display, (int) 10);
+							}
+
+							if(trigger.sources & TRIGGER_HEADER_MATCH) {
+								xil_printf("\nMatch word - ");
+								trigger.matchWord = get_u32_value(pParams, display, (int) 10);
+
+								xil_printf("\nMatch mask - 0x");
+								trigger.matchMask = get_u32_value(pParams, display, (int) 16);
+
+								xil_printf("\nMatch value - 0x");
+								trigger.matchValue = get_u32_value(pParams, display, (int) 16);
+							}
+
+							triggerArm(&trigger);
+							xil_printf("\n");
+							break;
+						case 'D' :
+						case 'd' :
+							triggerDisarm();
+							break;
+						case 'T' :
+						case 't' :
+							if(CaptureTriggerTest(pParams) != XST_SUCCESS)
+								xil_printf("Trigger test FAILED\n");
+							else
+								xil_printf("Trigger test passed\n");
+							break;
+						default:
+							break;
+					}
+
+					displayCapture(0);
+					xil_printf("\n>");
+
+					break;
+
+				case 'P':										// replay frames
+				case 'p':
+					s_status_register = *pParams->ptr_GpioStatusReg;
+
+					if(pParams->ptr_sStatusRegister->channel_up == 1) {
+						xil_printf("\nSource (C-capture ring, D-DDR) - ");
+
+						while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+						tempRead = pParams->pUART->rx;						// get character
+
+						xil_printf("%c\n",tempRead);
+
+						replay.timing = REPLAY_TIMING_RATE;
+
+						if((tempRead == 'D') || (tempRead == 'd')) {
+							replay.source = REPLAY_SOURCE_PRELOAD;
+
+							xil_printf("First frame address - 0x");
+							replay.address = (u8 *)get_u32_value(pParams, display, (int) 16);
+
+							xil_printf("\nFrames - ");
+							replay.frames = get_u32_value(pParams, display, (int) 10);
+						} else {
+							replay.source = REPLAY_SOURCE_CAPTURE;
+
+							xil_printf("Frames (0 - all) - ");
+							replay.frames = get_u32_value(pParams, display, (int) 10);
+
+							xil_printf("\nTiming (R-recorded, F-fixed rate) - ");
+
+							while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+							tempRead = pParams->pUART->rx;						// get character
+
+							xil_printf("%c",tempRead);
+
+							if((tempRead == 'R') || (tempRead == 'r'))
+								replay.timing = REPLAY_TIMING_RECORDED;
+						}
+
+						replay.rate = 0;
+						if(replay.timing == REPLAY_TIMING_RATE) {
+							xil_printf("\nFrames per second (0 - line rate) - ");
+							replay.rate = get_u32_value(pParams, display, (int) 10);
+						}
+
+						xil_printf("\nPasses (0 - until key press) - ");
+						replay.passes = get_u32_value(pParams, display, (int) 10);
+						xil_printf("\n");
+
+						status = runReplay(pParams, &replay);
+						if (status != XST_SUCCESS)
+							xil_printf("Replay FAILED\n");
+						xil_printf("\n>");
+					} else xil_printf("Aurora channel not UP\n>");
+
+					break;
+
+				case 'H':										// rate shaper
+				case 'h':
+					xil_printf("\nRate (bytes/s, 0 - off) - ");
+					rate = get_u32_value(pParams, display, (int) 10);
+
+					burst = 0;
+					if(rate) {
+						xil_printf("\nBurst (bytes) - ");
+						burst = get_u32_value(pParams, display, (int) 10);
+					}
+
+					if(shaperInit(rate, burst) != XST_SUCCESS)
+						xil_printf("\nburst over 0x%08X bytes or longer to fill than the timer wraps, unchanged", SHAPER_MAX_BURST);
+
+					displayShaper();
+					xil_printf("\n>");
+
+					break;
+
+				case 'Q':										// transmit queues
+				case 'q':
+					xil_printf("\nScheduling (S-strict, W-weighted) - ");
+
+					while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+					tempRead = pParams->pUART->rx;						// get character
+
+					xil_printf("%c\n",tempRead);
+
+					weight = 1;
+					if((tempRead == 'W') || (tempRead == 'w')) {
+						xil_printf("High priority frames per low priority frame - ");
+						weight = get_u32_value(pParams, display, (int) 10);
+						xil_printf("\n");
+					}
+
+					xil_printf("Small frame dataSize (0 - routing table only) - ");
+					smallFrame = get_u32_value(pParams, display, (int) 10);
+
+					txqInit(((tempRead == 'W') || (tempRead == 'w')) ? TXQ_WEIGHTED : TXQ_STRICT, weight, smallFrame);
+
+					displayTxq();
+					xil_printf("\n>");
+
+					break;
+
+				case 'Z':										// range reduction
+				case 'z':
+					xil_printf("\nMode (O-off, D-decimate, A-average) - ");
+
+					while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+					tempRead = pParams->pUART->rx;						// get character
+
+					xil_printf("%c\n",tempRead);
+
+					if((tempRead == 'O') || (tempRead == 'o')) {
+						reduceInit();
+					} else if((tempRead == 'D') || (tempRead == 'd') || (tempRead == 'A') || (tempRead == 'a')) {
+						xil_printf("Range (0-7, 255 - all) - ");
+						range = get_u32_value(pParams, display, (int) 10);
+
+						xil_printf("\nFactor (1, 2, 4 .. 256) - ");
+						factor = get_u32_value(pParams, display, (int) 10);
+
+						if(reduceSet(((tempRead == 'A') || (tempRead == 'a')) ? REDUCE_AVERAGE : REDUCE_DECIMATE, range, factor) != XST_SUCCESS)
+							xil_printf("\nBad range or factor\n");
+					}
+
+					displayReduce();
+					xil_printf("\n>");
+
+					break;
+
+				case 'K':										// sample packing
+				case 'k':
+					xil_printf("\nWidth (0 - off, 16, 24) - ");
+					width = get_u32_value(pParams, display, (int) 10);
+
+					shift = 0;
+					packedChannel = PACK_ALL_CHANNELS;
+					if(width != PACK_OFF) {
+						xil_printf("\nChannel (0-31, 255 - all) - ");
+						packedChannel = get_u32_value(pParams, display, (int) 10);
+
+						xil_printf("\nShift - ");
+						shift = get_u32_value(pParams, display, (int) 10);
+					}
+
+					if(packSet(width, packedChannel, shift) != XST_SUCCESS)
+						xil_printf("\nBad width, channel or shift\n");
+
+					displayPack();
+					xil_printf("\n>");
+
+					break;
+
+				case 'D':										// delta compression
+				case 'd':
+					xil_printf("\nE - Enable, D - Disable, B - Benchmark - ");
+
+					while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+					tempRead = pParams->pUART->rx;						// get character
+
+					xil_printf("%c\n",tempRead);
+
+					switch(tempRead) {
+						case 'E':
+						case 'e':
+							compressEnable(1);
+							break;
+
+						case 'D':
+						case 'd':
+							compressEnable(0);
+							break;
+
+						case 'B':
+						case 'b':
+							if(CompressionBenchmark(pParams) != XST_SUCCESS)
+								xil_printf("Benchmark FAILED\n");
+							break;
+
+						default:
+							break;
+					}
+
+					displayCompress();
+					xil_printf("\n>");
+
+					break;
+
+				case 'Y':										// frame CRC
+				case 'y':
+					xil_printf("\nTransmit trailer (E - Enable, D - Disable) - ");
+
+					while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+					tempRead = pParams->pUART->rx;						// get character
+
+					xil_printf("%c\n",tempRead);
+
+					if((tempRead == 'E') || (tempRead == 'e'))
+						crcEnable(1);
+					else if((tempRead == 'D') || (tempRead == 'd'))
+						crcEnable(0);
+
+					displayCrc();
+					xil_printf("\n>");
+
+					break;
+
+				case 'O':										// polled DMA completion
+				case 'o':
+					xil_printf("\nLargest polled transfer (bytes, 0 - off) - ");
+					pollBytes = get_u32_value(pParams, display, (int) 10);
+
+					pollBudgetUs = DMA_POLL_BUDGET_US;
+					if(pollBytes) {
+						xil_printf("\nPoll budget (us) - ");
+						pollBudgetUs = get_u32_value(pParams, display, (int) 10);
+					}
+
+					dmaPollSet(pollBytes, pollBudgetUs);
+
+					displayDmaPoll();
+					xil_printf("\n>");
+
+					break;
+
+				case 'W':										// DMA watchdog
+				case 'w':
+					xil_printf("\nMM2S deadline (us, 0 - none) - ");
+					deadlineUs = get_u32_value(pParams, display, (int) 10);
+					dmaWatchdogSet(DMA_WATCH_MM2S, deadlineUs);
+
+					xil_printf("\nS2MM deadline (us, 0 - none) - ");
+					deadlineUs = get_u32_value(pParams, display, (int) 10);
+					dmaWatchdogSet(DMA_WATCH_S2MM, deadlineUs);
+
+					xil_printf("\nHost deadline (us, 0 - none) - ");
+					deadlineUs = get_u32_value(pParams, display, (int) 10);
+					dmaWatchdogSet(DMA_WATCH_HOST, deadlineUs);
+
+					displayDmaWatchdog();
+					xil_printf("\n>");
+
+					break;
+
+				case 'U':										// endian swap
+				case 'u':
+					xil_printf("\nEndian (S-swap region, T-test) - ");
+
+					while(!(status= pParams->pUART->status & 0x0001)); 	// wait for character
+
+					tempRead = pParams->pUART->rx;						// get character
+
+					xil_printf("%c\n",tempRead);
+
+					switch (tempRead) {
+						case 'S' :
+						case 's' :
+							xil_printf("Start Address - 0x");
+							startAddr = get_u32_value(pParams, display, (int) 16);
+
+							xil_printf("\nWords - ");
+							wordsToRead = get_u32_value(pParams, display, (int) 10);
+
+							swap_endian_buffer((void *)startAddr, wordsToRead);
+							cacheFlush((void *)startAddr, wordsToRead * 4);
+
+							xil_printf("\nSwapped %d words at 0x%08X\n", wordsToRead, startAddr);
+							break;
+						case 'T' :
+						case 't' :
+							if(EndianSwapTest(pParams) != XST_SUCCESS)
+								xil_printf("Swap test FAILED\n");
+							break;
+						default:
+							break;
+					}
+
+					xil_printf("\n>");
+
+					break;
+
+				case 'N':										// NWL status queue
+				case 'n':
+					xil_printf("\nEnter Channel - ");
+					channel = get_u32_value(pParams, display, (int) 10);
+
+					if(channel >= NWL_CHANNELS)
+						xil_printf("\nNo such channel\n");
+					else if(nwlReaperInit(pParams, channel) != XST_SUCCESS)
+						xil_printf("\nChannel %d status queue is not on the AXI side\n", channel);
+
+					displayNwlReaper();
+					xil_printf("\n>");
+
+					break;
+
+				case 'B':										// code placement
+				case 'b':
+					displayPlacement();
+					xil_printf("\n>");
+
+					break;
+
 				case 'M':										// display menu
 				case 'm':
 					display_menu(pParams);
@@ -698,9 +1414,9 @@ int main()
 					resetAxiInterrupt(0);
 
 					/*Clear DDR*/
-					clear_ddr((unsigned int *) 0x80000000, (unsigned int *) 0x80010000, 0x00, 1);
+					clear_ddr((unsigned int *) pParams->dataSourceLocation, (unsigned int *) (pParams->dataSourceLocation + 0x10000), 0x00, 1);
 
-					uc_writeAddress = (unsigned char *)0x80000000;
+					uc_writeAddress = (unsigned char *)pParams->dataSourceLocation;
 
 					/* wait for interrupt */
 					while ( !(s_intr_rx & 0x00000001) ) {
@@ -753,9 +1469,7 @@ int main()
 
 	} // end of while
 
-    return 0;
-
-} // end of main
+} // end of runMenu
 
 
 